@@ -9,8 +9,15 @@
       "target_name": "adabas",
       "sources": [
         "../src/adabas.cxx",
+        "../src/buffer_pool.cxx",
+        "../src/codec.cxx",
         "../src/command.cxx",
-        "../src/node_adabas.cxx"
+        "../src/flight_recorder.cxx",
+        "../src/format_buffer.cxx",
+        "../src/histogram.cxx",
+        "../src/metrics.cxx",
+        "../src/node_adabas.cxx",
+        "../src/transcode.cxx"
       ],
       "conditions": [
         ["OS=='win'", {
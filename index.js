@@ -1,6 +1,34 @@
+var events = require('events');
+
 var adabas = module.exports = exports = require('./lib/adabas.node');
+var ReadStream = require('./lib/read_stream');
+var Search = require('./lib/search');
+var CommandPool = require('./lib/command_pool');
+var ControlBlock = require('./lib/control_block');
 
 function inherits(target, source) {
   for (var k in source.prototype)
     target.prototype[k] = source.prototype[k];
 }
+
+// Adabas instance emits event 'drain' when backpressure is released.
+inherits(adabas.Adabas, events.EventEmitter);
+
+adabas.ReadStream = ReadStream;
+
+adabas.Adabas.prototype.createReadStream = function(command, options) {
+  return new ReadStream(this, command, options);
+};
+
+adabas.Search = Search;
+adabas.CommandPool = CommandPool;
+adabas.Command.prepare = CommandPool.prepare;
+
+// Control block fields are accessed without native calls: command.cb.isn.
+adabas.ControlBlock = ControlBlock;
+ControlBlock.install(adabas.Command);
+
+// Starts search criteria: adabas.where('AW,6,A').eq('READER').
+adabas.where = function(field) {
+  return new Search().where(field);
+};
@@ -0,0 +1,89 @@
+var adabas = require('./adabas.node');
+
+/*
+ * Pool of recycled commands, which are cloned from the prepared command
+ * (template). Commands are reused, so the hot path doesn't create and
+ * finalize Command objects, and only parameters (ISN, values, ...) are
+ * set after acquire(). Options: 'maxSize' (free commands kept by the
+ * pool, default 64), 'db' (Adabas instance, whose buffer pool provides
+ * buffers of the commands).
+ */
+function CommandPool(template, options) {
+  if (!(this instanceof CommandPool))
+    return new CommandPool(template, options);
+
+  options = options || {};
+  if (options.db)
+    options.db.adopt(template);
+  this.template = template;
+  this.maxSize = options.maxSize || 64;
+  this.free = [];
+  this.created = 0;
+  this.reused = 0;
+}
+
+/*
+ * Returns command with fields and buffers of the template.
+ */
+CommandPool.prototype.acquire = function() {
+  var command = this.free.pop();
+  if (command === undefined) {
+    this.created++;
+    return this.template.clone();
+  }
+  this.reused++;
+  return this.template.clone(command);
+};
+
+/*
+ * Returns command to the pool (command must not be executed anymore).
+ */
+CommandPool.prototype.release = function(command) {
+  if (this.free.length < this.maxSize)
+    this.free.push(command);
+};
+
+CommandPool.prototype.stats = function() {
+  return {
+    created: this.created,
+    reused: this.reused,
+    free: this.free.length
+  };
+};
+
+/*
+ * Creates prepared command (template) from fields: prepare({ commandCode:
+ * 'L1', dbId: 88, fileNo: 12, formatBuffer: 'AA,AB.', recordBuffer: 250,
+ * ... }). Field names are names of the setters without 'set'. Buffers
+ * are buffers, strings or lengths, lengths of buffers are set unless
+ * they are passed. Length of record, value or ISN buffer only sets the
+ * length (clones get buffers without default contents), length of
+ * format or search buffer creates new buffer.
+ */
+CommandPool.prepare = function(fields) {
+  var command = new adabas.Command();
+  var values = {};
+  for (var name in fields) {
+    var setter = 'set' + name.charAt(0).toUpperCase() + name.slice(1);
+    if (typeof command[setter] !== 'function')
+      throw new Error('unknown field of the command: ' + name);
+
+    var value = fields[name];
+    if (/Buffer$/.test(name)) {
+      var privateBuffer = /^(record|value|isn)Buffer$/.test(name);
+      if (typeof value === 'string')
+        value = new Buffer(value, 'binary');
+      else if (typeof value === 'number' && !privateBuffer)
+        value = new Buffer(value);
+      var length = typeof value === 'number' ? value : value.length;
+      if (fields[name + 'Length'] === undefined)
+        values[name + 'Length'] = length;
+      if (typeof value === 'number')
+        continue;
+    }
+    values[name] = value;
+  }
+  return command.set(values);
+};
+
+module.exports = CommandPool;
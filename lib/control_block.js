@@ -0,0 +1,194 @@
+var os = require('os');
+
+var adabas = require('./adabas.node');
+
+var layout = adabas.controlBlockLayout;
+var bigEndian = os.endianness() === 'BE';
+
+/*
+ * Control block of the command, which is accessed in JS through Buffer
+ * sharing memory with the native control block: command.cb.isn = 5.
+ * Setters of numeric fields don't validate values (alphanumeric fields
+ * are checked like in native setters); in debug mode (ControlBlock.debug
+ * or environment variable NODE_ADABAS_DEBUG) they call native setters,
+ * which validate values and throw errors.
+ */
+function ControlBlock(command) {
+  this.command = command;
+  this.buffer = command.getControlBlock();
+}
+
+ControlBlock.debug = !!process.env.NODE_ADABAS_DEBUG;
+
+/*
+ * Returns accessors of the integer field.
+ */
+function integerAccessors(offset, size) {
+  var read, write;
+  switch (size) {
+  case 1:
+    read = 'readUInt8';
+    write = 'writeUInt8';
+    break;
+  case 2:
+    read = bigEndian ? 'readUInt16BE' : 'readUInt16LE';
+    write = bigEndian ? 'writeUInt16BE' : 'writeUInt16LE';
+    break;
+  default:
+    read = bigEndian ? 'readUInt32BE' : 'readUInt32LE';
+    write = bigEndian ? 'writeUInt32BE' : 'writeUInt32LE';
+  }
+  return {
+    get: function() {
+      return this.buffer[read](offset, true);
+    },
+    set: function(value) {
+      this.buffer[write](value, offset, true);
+    }
+  };
+}
+
+/*
+ * Returns accessors of the alphanumeric field (Latin-1).
+ */
+function stringAccessors(offset, size) {
+  return {
+    get: function() {
+      return this.buffer.toString('binary', offset, offset + size);
+    },
+    set: function(value) {
+      if (typeof value !== 'string')
+        throw new Error('argument must be a string');
+      if (value.length !== size)
+        throw new Error('invalid length of the argument');
+      var i;
+      for (i = 0; i < size; i++) {
+        if (value.charCodeAt(i) > 0xFF)
+          throw new Error('character can\'t be represented in the code page');
+      }
+      for (i = 0; i < size; i++)
+        this.buffer[offset + i] = value.charCodeAt(i);
+    }
+  };
+}
+
+/*
+ * Returns accessors of the byte array field.
+ */
+function arrayAccessors(offset, size) {
+  return {
+    get: function() {
+      var array = new Array(size);
+      for (var i = 0; i < size; i++)
+        array[i] = this.buffer[offset + i];
+      return array;
+    },
+    set: function(value) {
+      for (var i = 0; i < size; i++)
+        this.buffer[offset + i] = value[i];
+    }
+  };
+}
+
+/*
+ * Database ID and file number above 254 are stored in other fields of
+ * the control block (physical file number), native calls handle them.
+ */
+var PHYSICAL_FILE_NUMBER = 0xFF;
+var dbIdOffset = layout.fields.dbId[0];
+
+function fileAccessors(name, offset) {
+  var getter = 'get' + name;
+  var setter = 'set' + name;
+  return {
+    get: function() {
+      if (this.buffer[dbIdOffset] === PHYSICAL_FILE_NUMBER)
+        return this.command[getter]();
+      return this.buffer[offset];
+    },
+    set: function(value) {
+      if (value >= PHYSICAL_FILE_NUMBER ||
+        this.buffer[dbIdOffset] === PHYSICAL_FILE_NUMBER)
+      {
+        this.command[setter](value);
+        return;
+      }
+      this.buffer[offset] = value;
+    }
+  };
+}
+
+/*
+ * Return code holds database ID and file number of physical file
+ * numbers, native calls check it.
+ */
+function returnCodeAccessors(offset, size) {
+  var accessors = integerAccessors(offset, size);
+  return {
+    get: function() {
+      if (this.buffer[dbIdOffset] === PHYSICAL_FILE_NUMBER)
+        return this.command.getReturnCode();
+      return accessors.get.call(this);
+    },
+    set: function(value) {
+      if (this.buffer[dbIdOffset] === PHYSICAL_FILE_NUMBER) {
+        this.command.setReturnCode(value);
+        return;
+      }
+      accessors.set.call(this, value);
+    }
+  };
+}
+
+// Accessors are generated from the layout of the control block.
+Object.keys(layout.fields).forEach(function(name) {
+  var offset = layout.fields[name][0];
+  var size = layout.fields[name][1];
+  var methodName = name.charAt(0).toUpperCase() + name.slice(1);
+
+  var accessors;
+  if (name === 'dbId' || name === 'fileNo') {
+    accessors = fileAccessors(methodName, offset);
+  } else if (name === 'returnCode') {
+    accessors = returnCodeAccessors(offset, size);
+  } else if (name === 'commandCode' || name === 'commandId') {
+    accessors = stringAccessors(offset, size);
+  } else if (/^addition|^userArea$/.test(name)) {
+    accessors = arrayAccessors(offset, size);
+  } else {
+    accessors = integerAccessors(offset, size);
+  }
+
+  var fastSet = accessors.set;
+  var setter = 'set' + methodName;
+  accessors.set = function(value) {
+    if (ControlBlock.debug)
+      this.command[setter](value);
+    else
+      fastSet.call(this, value);
+  };
+  accessors.enumerable = true;
+
+  Object.defineProperty(ControlBlock.prototype, name, accessors);
+});
+
+/*
+ * Defines property 'cb' of commands (control block is created once per
+ * command).
+ */
+ControlBlock.install = function(Command) {
+  Object.defineProperty(Command.prototype, 'cb', {
+    get: function() {
+      if (this._controlBlock === undefined) {
+        Object.defineProperty(this, '_controlBlock', {
+          value: new ControlBlock(this)
+        });
+      }
+      return this._controlBlock;
+    }
+  });
+};
+
+ControlBlock.layout = layout;
+
+module.exports = ControlBlock;
@@ -0,0 +1,58 @@
+var Readable = require('stream').Readable;
+var util = require('util');
+
+/*
+ * Readable stream of records read by the command (L2, L3, ...) with
+ * Adabas.readAll(). Stream emits chunks '{ records, isns }' in object
+ * mode, where records is a buffer with records of the record buffer
+ * length one after another. Options: 'maxRecords', 'chunkRecords',
+ * 'prefetch' (chunks read ahead while the consumer is busy) and
+ * 'highWaterMark' (chunks buffered by the stream).
+ */
+function ReadStream(db, command, options) {
+  if (!(this instanceof ReadStream))
+    return new ReadStream(db, command, options);
+
+  options = options || {};
+  Readable.call(this, {
+    objectMode: true,
+    highWaterMark: options.highWaterMark || 1
+  });
+
+  this.db = db;
+  this.command = command;
+  this.options = {
+    maxRecords: options.maxRecords || 0,
+    chunkRecords: options.chunkRecords || 100,
+    prefetch: options.prefetch || 1
+  };
+  this.started = false;
+  this.rc = undefined;
+  this.numRecords = 0;
+}
+util.inherits(ReadStream, Readable);
+
+ReadStream.prototype._read = function() {
+  if (this.started) {
+    this.db.resumeRead(this.command);
+    return;
+  }
+  this.started = true;
+
+  var self = this;
+  this.db.readAll(this.command, this.options,
+    function(records, isns) {
+      return self.push({ records: records, isns: isns });
+    },
+    function(err, rc, numRecords) {
+      if (err) {
+        self.emit('error', err);
+        return;
+      }
+      self.rc = rc;
+      self.numRecords = numRecords;
+      self.push(null);
+    });
+};
+
+module.exports = ReadStream;
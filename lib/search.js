@@ -0,0 +1,180 @@
+var adabas = require('./adabas.node');
+
+// Maximal number of cached search plans.
+var PLAN_CACHE_SIZE = 256;
+
+var plans = {};
+var numPlans = 0;
+
+/*
+ * Search criteria, which are compiled into the search buffer and the
+ * value buffer:
+ *
+ *   adabas.where('AW,6,A').eq('READER').and('AB').between(100, 200)
+ *
+ * Field is 'name,length,format' or just 'name', then length and format
+ * are taken from the value (string - A, integer - F, number - G,
+ * buffer - B). Search buffer and format of the value buffer are cached
+ * per shape of the criteria (fields, lengths, formats and operators), so
+ * repeated searches only encode values.
+ */
+function Search() {
+  if (!(this instanceof Search))
+    return new Search();
+
+  this.shape = '';
+  this.values = {};
+  this.numValues = 0;
+  this.field = null;
+}
+
+/*
+ * Returns 'name,length,format' of the field for the value.
+ */
+function fieldOf(field, value) {
+  if (field.indexOf(',') >= 0)
+    return field.replace(/\s/g, '').toUpperCase();
+
+  var name = field.toUpperCase();
+  if (typeof value === 'string') {
+    if (value.length === 0 || value.length > 253)
+      throw new Error('invalid length of the value for the field ' + name);
+    return name + ',' + value.length + ',A';
+  }
+  if (Buffer.isBuffer(value))
+    return name + ',' + value.length + ',B';
+  if (typeof value === 'number') {
+    if (value % 1 !== 0)
+      return name + ',8,G';
+    if (value >= -0x80000000 && value <= 0x7FFFFFFF)
+      return name + ',4,F';
+    return name + ',8,F';
+  }
+  throw new Error('length and format of the field ' + name +
+    ' must be specified');
+}
+
+Search.prototype.where = function(field) {
+  if (this.field !== null)
+    throw new Error('operator expected after the field ' + this.field);
+  this.field = field;
+  return this;
+};
+
+Search.prototype.and = function(field) {
+  this.shape += ',D,';
+  return this.where(field);
+};
+
+Search.prototype.or = function(field) {
+  this.shape += ',O,';
+  return this.where(field);
+};
+
+Search.prototype.compare = function(operator, value) {
+  if (this.field === null)
+    throw new Error('field expected before the operator');
+  this.shape += fieldOf(this.field, value) + operator;
+  this.values['V' + (++this.numValues)] = value;
+  this.field = null;
+  return this;
+};
+
+Search.prototype.eq = function(value) {
+  return this.compare('', value);
+};
+
+Search.prototype.ne = function(value) {
+  return this.compare(',NE', value);
+};
+
+Search.prototype.gt = function(value) {
+  return this.compare(',GT', value);
+};
+
+Search.prototype.ge = function(value) {
+  return this.compare(',GE', value);
+};
+
+Search.prototype.lt = function(value) {
+  return this.compare(',LT', value);
+};
+
+Search.prototype.le = function(value) {
+  return this.compare(',LE', value);
+};
+
+Search.prototype.between = function(from, to) {
+  var field = this.field;
+  this.compare(',S,', from);
+  this.field = field;
+  return this.compare('', to);
+};
+
+/*
+ * Returns compiled plan of the search: search buffer and format of the
+ * value buffer.
+ */
+Search.prototype.plan = function() {
+  if (this.field !== null || this.numValues === 0)
+    throw new Error('search criteria are incomplete');
+
+  var plan = plans[this.shape];
+  if (plan !== undefined)
+    return plan;
+
+  // Value formats are the fields of the search buffer in order, named
+  // V1, V2, ...
+  var elements = this.shape.split(',');
+  var format = [];
+  for (var i = 0; i + 2 < elements.length; i++) {
+    if (!/^[A-Z]/.test(elements[i]) || !/^\d+$/.test(elements[i + 1]))
+      continue;
+    format.push('V' + (format.length + 1) + ',' + elements[i + 1] + ',' +
+      elements[i + 2]);
+    i += 2;
+  }
+
+  var formatBuffer = adabas.compileFormat(format.join(',') + '.');
+  plan = {
+    searchBuffer: new Buffer(this.shape + '.', 'binary'),
+    formatBuffer: formatBuffer,
+    valueLength: formatBuffer.getRecordLength()
+  };
+
+  if (numPlans >= PLAN_CACHE_SIZE) {
+    plans = {};
+    numPlans = 0;
+  }
+  plans[this.shape] = plan;
+  numPlans++;
+  return plan;
+};
+
+/*
+ * Sets search buffer and value buffer of the command. Value buffer is
+ * allocated once per command and rewritten in place by the next search
+ * with this command.
+ */
+Search.prototype.apply = function(command) {
+  var plan = this.plan();
+
+  var valueBuffer = command._searchValueBuffer;
+  if (valueBuffer === undefined || valueBuffer.length < plan.valueLength) {
+    valueBuffer = new Buffer(Math.max(plan.valueLength, 64));
+    command._searchValueBuffer = valueBuffer;
+  }
+  var valueLength = plan.formatBuffer.encode(this.values, valueBuffer);
+
+  return command
+    .setSearchBufferLength(plan.searchBuffer.length)
+    .setSearchBuffer(plan.searchBuffer)
+    .setValueBufferLength(valueLength)
+    .setValueBuffer(valueBuffer);
+};
+
+Search.prototype.toString = function() {
+  return this.shape + '.';
+};
+
+module.exports = Search;
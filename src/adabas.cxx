@@ -1,16 +1,55 @@
+#include <algorithm>
+#include <csignal>
 #include <cstdlib>
+#include <cstring>
 #include <node.h>
+#include <node_buffer.h>
 #include <set>
 #include <string>
 
+#ifdef WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif // WIN32
+
 #include "adabas.h"
+#include "transcode.h"
 #include "v8_helpers.h"
 
 namespace node_adabas {
 
-static uv_mutex_t requestsMutex;
-static uv_mutex_t finishedRequestsMutex;
-static uv_mutex_t threadsMutex;
+// Default number of request slots of the Adabas instance.
+#define DEFAULT_QUEUE_DEPTH 32
+
+// Maximal number of threads with sessions (thread number is a byte of
+// the Adabas ID).
+#define MAX_SESSION_THREADS 255
+
+// Default and maximal number of samples of gauges (gauges()).
+#define DEFAULT_SAMPLE_WINDOW 60
+#define MAX_SAMPLE_WINDOW 3600
+
+// Default number of slow calls kept by each thread and number of bytes
+// copied from each buffer of the slow call.
+#define DEFAULT_SLOW_LOG_SIZE 32
+#define DEFAULT_SLOW_COMMAND_BYTES 64
+
+// Maximal number of calls in the flight recorder and the slow log.
+#define MAX_FLIGHT_RECORDER 0x10000
+
+// Maximal threshold of slow calls (one day).
+#define MAX_SLOW_COMMAND_MS 86400000
+
+// Names of request phases (timing()).
+static const char* phaseNames[] = {
+	"wakeup", "queue", "dispatch", "call", "completion", "total",
+	"commandTime"
+};
+
+// Number of Adabas instances (makes Adabas IDs of sessions unique).
+static unsigned int numInstances = 0;
 
 /*
  * Initializes and finalizes static module variables.
@@ -22,18 +61,10 @@ public:
 #ifdef _DEBUG
 		fprintf(stderr, "[module-enter]\n");
 #endif // _DEBUG
-
-		uv_mutex_init(&requestsMutex);
-		uv_mutex_init(&finishedRequestsMutex);
-		uv_mutex_init(&threadsMutex);
 	}
 
 	~ModuleInit()
 	{
-		uv_mutex_destroy(&requestsMutex);
-		uv_mutex_destroy(&finishedRequestsMutex);
-		uv_mutex_destroy(&threadsMutex);
-
 #ifdef _DEBUG
 		fprintf(stderr, "[module-exit]\n");
 #endif // _DEBUG
@@ -55,44 +86,176 @@ static struct AdabasObjects : public std::set<Adabas*> {
 
 v8::Persistent<v8::Function> Adabas::constructor;
 
+static v8::Persistent<v8::String> indexSymbol;
+static v8::Persistent<v8::String> rcSymbol;
+static v8::Persistent<v8::String> emitSymbol;
+static v8::Persistent<v8::String> drainSymbol;
+
 /*
- * Constructor.
+ * Default options of the thread pool.
  */
-Adabas::Adabas() :
-	ObjectWrap()
+Adabas::Options::Options() :
+	minThreads(1),
+	maxThreads(0),
+	idleTimeoutMs(60000),
+	sessionsPerThread(0),
+	sessionDbId(0),
+	queueDepth(DEFAULT_QUEUE_DEPTH),
+	highWaterMark(0),
+	lowWaterMark(0),
+	waitQueue(0),
+	timing(false),
+	sampleIntervalMs(0),
+	sampleWindow(DEFAULT_SAMPLE_WINDOW),
+	flightRecorder(0),
+	slowCommandMs(0),
+	slowLogSize(DEFAULT_SLOW_LOG_SIZE),
+	slowCommandBytes(DEFAULT_SLOW_COMMAND_BYTES),
+	dumpOnSignal(false)
 {
-	adabasObjects.insert(this);
-
-	m_threads.resize(1);
-	for (size_t threadNo = 0; threadNo < m_threads.size(); threadNo++) {
-		Thread& thread = m_threads[threadNo];
-
-		thread.self = this;
-		thread.busy = false;
-
-		thread.threadLoop = uv_loop_new();
-		uv_sem_init(&thread.threadExitSemaphore, 0);
+}
 
-		thread.exitMessage = (uv_async_t*) malloc(sizeof(uv_async_t));
-		uv_async_init(thread.threadLoop, thread.exitMessage,
-			ThreadOnExit);
-		thread.exitMessage->data = (void*) &thread;
+/*
+ * Makes Adabas ID of the session: process ID, instance, thread and
+ * session numbers (session number 0 is the default ID of the thread).
+ */
+static void
+MakeAdabasId(unsigned char* adabasId, unsigned int instanceNo,
+	unsigned int threadNo, unsigned int sessionNo)
+{
+	uint32_t processId = (uint32_t) getpid();
+	adabasId[0] = (unsigned char) (processId >> 24);
+	adabasId[1] = (unsigned char) (processId >> 16);
+	adabasId[2] = (unsigned char) (processId >> 8);
+	adabasId[3] = (unsigned char) processId;
+	adabasId[4] = (unsigned char) instanceNo;
+	adabasId[5] = (unsigned char) threadNo;
+	adabasId[6] = (unsigned char) (sessionNo >> 8);
+	adabasId[7] = (unsigned char) sessionNo;
+}
 
-		thread.execMessage = (uv_async_t*) malloc(sizeof(uv_async_t));
-		uv_async_init(thread.threadLoop, thread.execMessage,
-			ThreadOnExec);
-		uv_unref((uv_handle_t*) thread.execMessage);
+/*
+ * Constructor.
+ */
+Adabas::Adabas(const Options& options) :
+	ObjectWrap(),
+	m_options(options),
+	m_finalized(false),
+	m_numThreads(0),
+	m_needDrain(false),
+	m_pendingCallbacks(0),
+	m_bufferPool(new BufferPool()),
+	m_dumpSignal(NULL),
+	m_busyRejections(0),
+	m_sampleTimer(NULL),
+	m_numSamples(0),
+	m_nextSample(0),
+	m_lastSampleTime(uv_hrtime()),
+	m_lastBusyRejections(0)
+{
+	adabasObjects.insert(this);
 
-		thread.execFinishedMessage =
-			(uv_async_t*) malloc(sizeof(uv_async_t));
-		uv_async_init(uv_default_loop(), thread.execFinishedMessage,
-			OnExecFinished);
-		uv_unref((uv_handle_t*) thread.execFinishedMessage);
+	// All request memory is allocated here, not in exec().
+	uint32_t queueDepth = m_options.queueDepth;
+	m_slots.resize(queueDepth);
+	m_freeSlots.reserve(queueDepth);
+	for (uint32_t slotNo = queueDepth; slotNo > 0; slotNo--) {
+		m_freeSlots.push_back(slotNo - 1);
+	}
+	for (uint32_t slotNo = 0; slotNo < queueDepth; slotNo++) {
+		m_slots[slotNo].batch = NULL;
+		m_slots[slotNo].chain = NULL;
+		m_slots[slotNo].reader = NULL;
+	}
 
-		uv_cond_init(&thread.execEndCond);
+	// Threads are started lazily by the first requests, but the thread
+	// table is allocated at once.
+	m_threads.resize(m_options.maxThreads);
+	for (uint32_t threadNo = 0; threadNo < m_options.maxThreads;
+		threadNo++)
+	{
+		Thread* thread = new Thread();
+		thread->self = this;
+		thread->threadNo = threadNo;
+		thread->state = THREAD_STOPPED;
+		thread->exited = 0;
+		thread->requests.Init(queueDepth);
+		thread->sessionRequests.Init(queueDepth);
+		thread->finishedRequests.Init(queueDepth);
+
+		thread->sessions.resize(m_options.sessionsPerThread);
+		for (uint32_t sessionNo = 0;
+			sessionNo < m_options.sessionsPerThread; sessionNo++)
+		{
+			Session& session = thread->sessions[sessionNo];
+			MakeAdabasId(session.adabasId, numInstances, threadNo,
+				sessionNo + 1);
+			session.rc = 0;
+			session.opened = 0;
+		}
+		MakeAdabasId(thread->adabasId, numInstances, threadNo, 0);
+		thread->currentSession = -2;
+		thread->wakeUpTime = 0;
+		thread->wakeUps = 0;
+		thread->steals = 0;
+		thread->busyTime = 0;
+		thread->busyTimeNs = 0;
+		thread->callLog.flightRecorder.Init(int(threadNo),
+			m_options.flightRecorder, m_options.slowLogSize,
+			SlowThreshold(), m_options.slowCommandBytes);
+
+		m_threads[threadNo] = thread;
+	}
+	numInstances++;
+
+	m_execFinishedMessage = (uv_async_t*) malloc(sizeof(uv_async_t));
+	uv_async_init(uv_default_loop(), m_execFinishedMessage, OnExecFinished);
+	m_execFinishedMessage->data = (void*) this;
+	uv_unref((uv_handle_t*) m_execFinishedMessage);
+
+	m_threadExitedMessage = (uv_async_t*) malloc(sizeof(uv_async_t));
+	uv_async_init(uv_default_loop(), m_threadExitedMessage, OnThreadExited);
+	m_threadExitedMessage->data = (void*) this;
+	uv_unref((uv_handle_t*) m_threadExitedMessage);
+
+	uv_sem_init(&m_execEndSemaphore, 0);
+
+	m_lastWakeUps.resize(m_options.maxThreads, 0);
+	m_lastSteals.resize(m_options.maxThreads, 0);
+	m_lastBusyTime.resize(m_options.maxThreads, 0);
+	m_busyPercents.resize(m_options.maxThreads, 0);
+
+	m_callLog.flightRecorder.Init(-1, m_options.flightRecorder,
+		m_options.slowLogSize, SlowThreshold(),
+		m_options.slowCommandBytes);
+#ifndef WIN32
+	if (m_options.dumpOnSignal) {
+		m_dumpSignal = (uv_signal_t*) malloc(sizeof(uv_signal_t));
+		uv_signal_init(uv_default_loop(), m_dumpSignal);
+		m_dumpSignal->data = (void*) this;
+		uv_signal_start(m_dumpSignal, OnDumpSignal, SIGUSR2);
+		uv_unref((uv_handle_t*) m_dumpSignal);
+	}
+#endif // WIN32
+	if (m_options.sampleIntervalMs > 0) {
+		m_samples.resize(m_options.sampleWindow);
+		m_sampleTimer = (uv_timer_t*) malloc(sizeof(uv_timer_t));
+		uv_timer_init(uv_default_loop(), m_sampleTimer);
+		m_sampleTimer->data = (void*) this;
+		uv_timer_start(m_sampleTimer, OnSample, m_options.sampleIntervalMs,
+			m_options.sampleIntervalMs);
+		uv_unref((uv_handle_t*) m_sampleTimer);
+	}
 
-		uv_thread_create(&thread.threadId, ThreadEventLoop,
-			(void*) &thread);
+	// Threads with sessions are started at once and never leave the pool
+	// (after all handles used by threads are initialized).
+	if (m_options.sessionsPerThread > 0) {
+		for (uint32_t threadNo = 0; threadNo < m_threads.size();
+			threadNo++)
+		{
+			StartThread(m_threads[threadNo]);
+			uv_async_send(m_threads[threadNo]->execMessage);
+		}
 	}
 }
 
@@ -103,6 +266,9 @@ Adabas::~Adabas()
 {
 	adabasObjects.erase(this);
 	Finalize();
+
+	// Pool is deleted when all its buffers are collected.
+	m_bufferPool->Release();
 }
 
 /*
@@ -119,6 +285,22 @@ Adabas::Initialize(v8::Handle<v8::Object> exports)
 	// Prototype.
 	V8_METHOD("close", Close);
 	V8_METHOD("exec", Exec);
+	V8_METHOD("execSync", ExecSync);
+	V8_METHOD("execMany", ExecMany);
+	V8_METHOD("execChain", ExecChain);
+	V8_METHOD("readAll", ReadAll);
+	V8_METHOD("readIsns", ReadIsns);
+	V8_METHOD("resumeRead", ResumeRead);
+	V8_METHOD("reserve", Reserve);
+	V8_METHOD("adopt", Adopt);
+	V8_METHOD("timing", Timing);
+	V8_METHOD("prometheus", Prometheus);
+	V8_METHOD("gauges", Gauges);
+	V8_METHOD("flightRecorder", FlightRecorderCalls);
+	V8_METHOD("slowLog", SlowLog);
+	V8_METHOD("dumpFlightRecorder", DumpFlightRecorder);
+	V8_METHOD("stats", Stats);
+	V8_METHOD("sessions", Sessions);
 
 	// Constants for 'Command option 1'.
 	V8_CONSTANT("ADA_KEEP_ISN", ADA_KEEP_ISN);
@@ -266,8 +448,52 @@ Adabas::Initialize(v8::Handle<v8::Object> exports)
 	constructor = v8::Persistent<v8::Function>::New(t->GetFunction());
 	exports->Set(v8::String::NewSymbol("Adabas"), constructor);
 
-	// Initialize generator of the random numbers.
-	srand((unsigned int) time(NULL));
+	indexSymbol = v8::Persistent<v8::String>::New(
+		v8::String::NewSymbol("index"));
+	rcSymbol = v8::Persistent<v8::String>::New(
+		v8::String::NewSymbol("rc"));
+	emitSymbol = v8::Persistent<v8::String>::New(
+		v8::String::NewSymbol("emit"));
+	drainSymbol = v8::Persistent<v8::String>::New(
+		v8::String::NewSymbol("drain"));
+}
+
+/*
+ * Reads unsigned integer option from the options object.
+ */
+static const char*
+GetOption(v8::Handle<v8::Object> options, const char* name,
+	unsigned int& value)
+{
+	v8::Local<v8::Value> optionValue =
+		options->Get(v8::String::NewSymbol(name));
+	if (optionValue->IsUndefined()) {
+		return NULL;
+	}
+	if (!optionValue->IsUint32()) {
+		return "option must be an unsigned 32-bit integer";
+	}
+	value = optionValue->Uint32Value();
+	return NULL;
+}
+
+/*
+ * Reads non-negative number option from the options object.
+ */
+static const char*
+GetOption(v8::Handle<v8::Object> options, const char* name, double& value)
+{
+	v8::Local<v8::Value> optionValue =
+		options->Get(v8::String::NewSymbol(name));
+	if (optionValue->IsUndefined()) {
+		return NULL;
+	}
+	double number = optionValue->NumberValue();
+	if (!optionValue->IsNumber() || !(number >= 0)) {
+		return "option must be a non-negative number";
+	}
+	value = number;
+	return NULL;
 }
 
 /*
@@ -279,10 +505,159 @@ Adabas::New(const v8::Arguments& args)
 	v8::HandleScope scope;
 
 	if (!args.IsConstructCall()) {
-		return scope.Close(constructor->NewInstance());
+		v8::Handle<v8::Value> constructorArgs[] = { args[0] };
+		return scope.Close(constructor->NewInstance(
+			args.Length() > 0 ? 1 : 0, constructorArgs));
+	}
+
+	if (args.Length() > 1) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	Options options;
+	if (args.Length() == 1 && !args[0]->IsUndefined()) {
+		if (!args[0]->IsObject()) {
+			return V8_ERROR("argument must be an object");
+		}
+		v8::Handle<v8::Object> optionsObject = args[0]->ToObject();
+
+		const char* rc = GetOption(optionsObject, "minThreads",
+			options.minThreads);
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "maxThreads",
+				options.maxThreads);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "idleTimeoutMs",
+				options.idleTimeoutMs);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "sessionsPerThread",
+				options.sessionsPerThread);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "sessionDbId",
+				options.sessionDbId);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "queueDepth",
+				options.queueDepth);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "highWaterMark",
+				options.highWaterMark);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "lowWaterMark",
+				options.lowWaterMark);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "waitQueue",
+				options.waitQueue);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "sampleIntervalMs",
+				options.sampleIntervalMs);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "sampleWindow",
+				options.sampleWindow);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "flightRecorder",
+				options.flightRecorder);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "slowCommandMs",
+				options.slowCommandMs);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "slowLogSize",
+				options.slowLogSize);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "slowCommandBytes",
+				options.slowCommandBytes);
+		}
+		if (rc) {
+			return V8_ERROR(rc);
+		}
+
+		options.timing = optionsObject->Get(
+			v8::String::NewSymbol("timing"))->BooleanValue();
+		options.dumpOnSignal = optionsObject->Get(
+			v8::String::NewSymbol("dumpOnSignal"))->BooleanValue();
+
+		v8::Local<v8::Value> recordBuffer = optionsObject->Get(
+			v8::String::NewSymbol("sessionRecordBuffer"));
+		if (!recordBuffer->IsUndefined()) {
+			if (!recordBuffer->IsString()) {
+				return V8_ERROR("option must be a string");
+			}
+			options.sessionRecordBuffer =
+				*v8::String::Utf8Value(recordBuffer);
+		}
+	}
+
+	// By default the pool does not grow above the minimal size.
+	if (options.maxThreads == 0) {
+		options.maxThreads =
+			options.minThreads > 0 ? options.minThreads : 1;
+	}
+	if (options.minThreads > options.maxThreads) {
+		return V8_ERROR("minThreads must not be greater than maxThreads");
+	}
+
+	// By default exec() returns false only when all slots are used.
+	if (options.queueDepth == 0 || options.queueDepth > 0x10000) {
+		return V8_ERROR("queueDepth must be in range 1..65536");
+	}
+	if (options.highWaterMark == 0 ||
+		options.highWaterMark > options.queueDepth)
+	{
+		options.highWaterMark = options.queueDepth;
+	}
+	if (options.lowWaterMark == 0) {
+		options.lowWaterMark = options.highWaterMark / 2;
+	}
+	if (options.lowWaterMark >= options.highWaterMark) {
+		return V8_ERROR(
+			"lowWaterMark must be less than highWaterMark");
+	}
+
+	if (options.sampleWindow == 0 ||
+		options.sampleWindow > MAX_SAMPLE_WINDOW)
+	{
+		return V8_ERROR("sampleWindow must be in range 1..3600");
+	}
+
+	if (options.flightRecorder > MAX_FLIGHT_RECORDER) {
+		return V8_ERROR("flightRecorder must be in range 0..65536");
+	}
+	if (options.slowLogSize == 0 ||
+		options.slowLogSize > MAX_FLIGHT_RECORDER)
+	{
+		return V8_ERROR("slowLogSize must be in range 1..65536");
+	}
+	if (options.slowCommandMs > MAX_SLOW_COMMAND_MS) {
+		return V8_ERROR("slowCommandMs must be in range 0..86400000");
+	}
+	if (options.slowCommandBytes > FlightRecorder::MAX_SLOW_BYTES) {
+		return V8_ERROR("slowCommandBytes must be in range 0..4096");
+	}
+
+	// Pool with sessions has fixed size.
+	if (options.sessionsPerThread > 0) {
+		if (options.sessionDbId == 0 || options.sessionDbId > 0xFFFF) {
+			return V8_ERROR("sessionDbId must be a database ID");
+		}
+		if (options.maxThreads > MAX_SESSION_THREADS) {
+			return V8_ERROR("too many threads with sessions");
+		}
+		options.minThreads = options.maxThreads;
 	}
 
-	Adabas* self = new Adabas();
+	Adabas* self = new Adabas(options);
 	self->Wrap(args.This());
 
 	return args.This();
@@ -299,53 +674,230 @@ onHandleClosed(uv_handle_t* handle)
 	}
 }
 
+/*
+ * Deletes the thread table of the finalized object.
+ */
+static void
+deleteThreads(std::vector<Adabas::Thread*>* threads)
+{
+	for (size_t threadNo = 0; threadNo < threads->size(); threadNo++) {
+		delete (*threads)[threadNo];
+	}
+	delete threads;
+}
+
+/*
+ * Frees message 'exec finished' and the thread table of the finalized
+ * object passed in its data.
+ */
+static void
+onExecFinishedClosed(uv_handle_t* handle)
+{
+	if (handle->data != NULL) {
+		deleteThreads(static_cast<std::vector<Adabas::Thread*>*>(
+			handle->data));
+	}
+	free(handle);
+}
+
+/*
+ * Closes the thread handles, so the thread event loop can finish.
+ * Must be called in the thread. Message 'exec' is freed in main thread
+ * by StopThread(), because main thread may still send it.
+ */
+static void
+closeThreadHandles(Adabas::Thread& thread)
+{
+	uv_close((uv_handle_t*) thread.exitMessage, onHandleClosed);
+	uv_close((uv_handle_t*) thread.execMessage, NULL);
+	uv_close((uv_handle_t*) thread.idleTimer, onHandleClosed);
+}
+
+/*
+ * Starts the thread of the stopped thread table entry (in main thread).
+ */
+void
+Adabas::StartThread(Thread* thread)
+{
+	AtomicStore(&thread->state, THREAD_BUSY);
+	AtomicStore(&thread->exited, 0);
+
+	thread->threadLoop = uv_loop_new();
+	uv_sem_init(&thread->threadExitSemaphore, 0);
+
+	thread->exitMessage = (uv_async_t*) malloc(sizeof(uv_async_t));
+	uv_async_init(thread->threadLoop, thread->exitMessage, ThreadOnExit);
+	thread->exitMessage->data = (void*) thread;
+
+	thread->execMessage = (uv_async_t*) malloc(sizeof(uv_async_t));
+	uv_async_init(thread->threadLoop, thread->execMessage, ThreadOnExec);
+	thread->execMessage->data = (void*) thread;
+	uv_unref((uv_handle_t*) thread->execMessage);
+
+	thread->idleTimer = (uv_timer_t*) malloc(sizeof(uv_timer_t));
+	uv_timer_init(thread->threadLoop, thread->idleTimer);
+	thread->idleTimer->data = (void*) thread;
+	uv_unref((uv_handle_t*) thread->idleTimer);
+
+	AtomicAdd(&m_numThreads, 1);
+	uv_thread_create(&thread->threadId, ThreadEventLoop, (void*) thread);
+
+#ifdef _DEBUG
+	fprintf(stderr, "[thread-start] %u\n", thread->threadNo);
+#endif // _DEBUG
+}
+
+/*
+ * Waits for the thread termination and frees thread resources
+ * (in main thread). Thread must be in state THREAD_EXITING.
+ */
+void
+Adabas::StopThread(Thread* thread)
+{
+	uv_thread_join(&thread->threadId);
+
+	uv_sem_destroy(&thread->threadExitSemaphore);
+	uv_loop_delete(thread->threadLoop);
+	thread->threadLoop = NULL;
+	free(thread->execMessage);
+	thread->execMessage = NULL;
+
+	AtomicStore(&thread->exited, 0);
+	AtomicStore(&thread->state, THREAD_STOPPED);
+}
+
+/*
+ * Selects the thread for the next request (in main thread): idle thread,
+ * new thread when the pool may grow, or busy thread with the shortest
+ * queue. Flag 'wakeUp' is set when the thread must be woken up.
+ */
+Adabas::Thread*
+Adabas::SelectThread(bool& wakeUp)
+{
+	for (;;) {
+		for (size_t threadNo = 0; threadNo < m_threads.size();
+			threadNo++)
+		{
+			Thread* thread = m_threads[threadNo];
+			if (AtomicLoad(&thread->state) == THREAD_IDLE &&
+				AtomicCompareExchange(&thread->state,
+					THREAD_IDLE, THREAD_BUSY))
+			{
+				wakeUp = true;
+				return thread;
+			}
+		}
+
+		if (AtomicLoad(&m_numThreads) < m_options.maxThreads) {
+			for (size_t threadNo = 0; threadNo < m_threads.size();
+				threadNo++)
+			{
+				Thread* thread = m_threads[threadNo];
+				if (AtomicLoad(&thread->state) == THREAD_STOPPED) {
+					StartThread(thread);
+					wakeUp = true;
+					return thread;
+				}
+			}
+		}
+
+		Thread* busyThread = NULL;
+		uint32_t minQueueSize = 0;
+		for (size_t threadNo = 0; threadNo < m_threads.size();
+			threadNo++)
+		{
+			Thread* thread = m_threads[threadNo];
+			if (AtomicLoad(&thread->state) != THREAD_BUSY) {
+				continue;
+			}
+			uint32_t queueSize = thread->requests.Size();
+			if (busyThread == NULL || queueSize < minQueueSize) {
+				busyThread = thread;
+				minQueueSize = queueSize;
+			}
+		}
+		if (busyThread != NULL) {
+			wakeUp = false;
+			return busyThread;
+		}
+
+		// All thread table entries are leaving the pool: wait for one of
+		// them, so its entry may be started again.
+		for (size_t threadNo = 0; threadNo < m_threads.size();
+			threadNo++)
+		{
+			Thread* thread = m_threads[threadNo];
+			if (AtomicLoad(&thread->state) == THREAD_EXITING) {
+				StopThread(thread);
+				break;
+			}
+		}
+	}
+}
+
 /*
  * Finalizes the Node.js object.
  */
 void
 Adabas::Finalize(void)
 {
+	if (m_finalized) {
+		return;
+	}
+	m_finalized = true;
+
 #ifdef _DEBUG
 	fprintf(stderr, "[finalize-begin]\n");
 #endif // _DEBUG
 
 	for (size_t threadNo = 0; threadNo < m_threads.size(); threadNo++) {
-		Thread& thread = m_threads[threadNo];
-		if (thread.threadId == 0) {
-			continue;
-		}
-
-		uv_unref((uv_handle_t*) thread.execMessage);
-		uv_close((uv_handle_t*) thread.execMessage, onHandleClosed);
-
-		uv_unref((uv_handle_t*) thread.execFinishedMessage);
-		uv_close((uv_handle_t*) thread.execFinishedMessage,
-			onHandleClosed);
+		Thread* thread = m_threads[threadNo];
 
+		// Thread in state THREAD_EXITING already leaves the pool.
+		uint32_t state = AtomicExchange(&thread->state, THREAD_EXITING);
+		if (state != THREAD_STOPPED) {
 #ifdef WIN32
-		// Windows terminates a threads before the module exits.
-		if (!moduleExitFlag) {
-			uv_async_send(thread.exitMessage);
-			uv_sem_wait(&thread.threadExitSemaphore);
-		}
+			// Windows terminates a threads before the module exits.
+			if (!moduleExitFlag) {
+				if (state != THREAD_EXITING) {
+					uv_async_send(thread->exitMessage);
+				}
+				uv_sem_wait(&thread->threadExitSemaphore);
+			}
 #else
-		// In Linux we don't need to worry about threads
-		// prematurely closing.
-		uv_async_send(thread.exitMessage);
-		uv_sem_wait(&thread.threadExitSemaphore);
+			// In Linux we don't need to worry about threads
+			// prematurely closing.
+			if (state != THREAD_EXITING) {
+				uv_async_send(thread->exitMessage);
+			}
+			uv_sem_wait(&thread->threadExitSemaphore);
 #endif
-		uv_sem_destroy(&thread.threadExitSemaphore);
-		uv_cond_destroy(&thread.execEndCond);
 
-		if (thread.threadId != 0) {
-			uv_thread_join(&thread.threadId);
-			thread.threadId = 0;
+			StopThread(thread);
 		}
+	}
 
-		if (thread.threadLoop != NULL) {
-			uv_loop_delete(thread.threadLoop);
-			thread.threadLoop = NULL;
-		}
+	if (m_sampleTimer != NULL) {
+		uv_timer_stop(m_sampleTimer);
+		uv_close((uv_handle_t*) m_sampleTimer, onHandleClosed);
+		m_sampleTimer = NULL;
+	}
+	if (m_dumpSignal != NULL) {
+		uv_signal_stop(m_dumpSignal);
+		uv_close((uv_handle_t*) m_dumpSignal, onHandleClosed);
+		m_dumpSignal = NULL;
+	}
+
+	uv_close((uv_handle_t*) m_threadExitedMessage, onHandleClosed);
+	uv_sem_destroy(&m_execEndSemaphore);
+
+	// Finished requests get their results, the rest are cancelled on the
+	// next turn of the loop by FinishRequests() (not at module exit, when
+	// callbacks can't be called).
+	if (m_pendingCallbacks > 0 && !moduleExitFlag) {
+		uv_async_send(m_execFinishedMessage);
+	} else {
+		CloseExecFinishedMessage();
 	}
 
 #ifdef _DEBUG
@@ -353,6 +905,168 @@ Adabas::Finalize(void)
 #endif // _DEBUG
 }
 
+/*
+ * Closes message 'exec finished' of the finalized object. Thread table is
+ * freed when the message is closed, because Finalize() may be called by
+ * a callback, while main thread walks the table (the loop doesn't run at
+ * module exit).
+ */
+void
+Adabas::CloseExecFinishedMessage(void)
+{
+	std::vector<Thread*>* threads = new std::vector<Thread*>();
+	threads->swap(m_threads);
+	if (moduleExitFlag) {
+		deleteThreads(threads);
+		threads = NULL;
+	}
+	m_execFinishedMessage->data = threads;
+	uv_unref((uv_handle_t*) m_execFinishedMessage);
+	uv_close((uv_handle_t*) m_execFinishedMessage, onExecFinishedClosed);
+}
+
+/*
+ * Passes results of the finished requests to callbacks and cancels the
+ * rest after the object is finalized (in main thread, on the turn of the
+ * loop after Finalize()).
+ */
+void
+Adabas::FinishRequests(void)
+{
+	for (size_t threadNo = 0; threadNo < m_threads.size(); threadNo++) {
+		ProcessFinishedRequests(m_threads[threadNo]);
+	}
+	ProcessFinishedBatches();
+	CancelRequests();
+	CloseExecFinishedMessage();
+}
+
+/*
+ * Callback of the cancelled request (reader's onDone() receives also
+ * result code and number of records read).
+ */
+struct CancelledCallback {
+	v8::Local<v8::Function> callback;
+	const char* syscall;
+	bool reader;
+	int rc;
+	uint32_t numRecords;
+};
+
+/*
+ * Fails requests, which are not finished when the object is finalized,
+ * with error ECANCELED: queued and waiting requests, batches, chains and
+ * readers (in main thread, after threads are stopped).
+ */
+void
+Adabas::CancelRequests(void)
+{
+	v8::HandleScope scope;
+
+	// Callbacks are called after all requests are released.
+	std::vector<CancelledCallback> cancelled;
+	CancelledCallback item;
+	item.syscall = "ExecRequest";
+	item.reader = false;
+	item.rc = 0;
+	item.numRecords = 0;
+
+	std::vector<bool> freeSlots(m_slots.size(), false);
+	for (size_t i = 0; i < m_freeSlots.size(); i++) {
+		freeSlots[m_freeSlots[i]] = true;
+	}
+
+	std::set<Batch*> batches(m_finishedBatches.begin(),
+		m_finishedBatches.end());
+	m_finishedBatches.clear();
+
+	for (uint32_t slotNo = 0; slotNo < m_slots.size(); slotNo++) {
+		if (freeSlots[slotNo]) {
+			continue;
+		}
+		Request& request = m_slots[slotNo];
+
+		if (request.batch != NULL) {
+			batches.insert(request.batch);
+			request.batch = NULL;
+		} else if (request.chain != NULL) {
+			Chain* chain = request.chain;
+			item.callback = v8::Local<v8::Function>::New(chain->callback);
+			cancelled.push_back(item);
+			chain->callback.Dispose();
+			chain->commands.Dispose();
+			delete chain;
+			request.chain = NULL;
+		} else if (request.reader != NULL) {
+			Reader* reader = request.reader;
+			CancelledCallback readerItem = item;
+			readerItem.callback =
+				v8::Local<v8::Function>::New(reader->onDone);
+			readerItem.syscall = reader->isnList ? "ReadIsns" : "ReadAll";
+			readerItem.reader = true;
+			readerItem.rc = request.rc;
+			readerItem.numRecords = reader->numRecords;
+			cancelled.push_back(readerItem);
+			free(reader->chunkData);
+			reader->onChunk.Dispose();
+			reader->onDone.Dispose();
+			reader->command.Dispose();
+			delete reader;
+			request.reader = NULL;
+		} else if (!request.callback.IsEmpty()) {
+			item.callback = v8::Local<v8::Function>::New(request.callback);
+			cancelled.push_back(item);
+			request.callback.Dispose();
+			request.callback.Clear();
+			request.command.Dispose();
+			request.command.Clear();
+		}
+		m_freeSlots.push_back(slotNo);
+	}
+
+	for (std::set<Batch*>::iterator it = batches.begin();
+		it != batches.end(); it++)
+	{
+		Batch* batch = *it;
+		item.callback = v8::Local<v8::Function>::New(batch->callback);
+		cancelled.push_back(item);
+		batch->callback.Dispose();
+		batch->commands.Dispose();
+		delete batch;
+	}
+
+	for (size_t i = 0; i < m_waitingRequests.size(); i++) {
+		WaitingRequest& waitingRequest = m_waitingRequests[i];
+		item.callback =
+			v8::Local<v8::Function>::New(waitingRequest.callback);
+		cancelled.push_back(item);
+		waitingRequest.callback.Dispose();
+		waitingRequest.command.Dispose();
+	}
+	m_waitingRequests.clear();
+
+	for (size_t i = 0; i < cancelled.size(); i++) {
+		Unref();
+		if (--m_pendingCallbacks == 0) {
+			uv_unref((uv_handle_t*) m_execFinishedMessage);
+		}
+	}
+
+	for (size_t i = 0; i < cancelled.size(); i++) {
+		v8::Local<v8::Value> callbackArgs[] = {
+			node::ErrnoException(ECANCELED, cancelled[i].syscall),
+			v8::Number::New(int32_t(cancelled[i].rc)),
+			v8::Integer::NewFromUnsigned(cancelled[i].numRecords)
+		};
+		v8::TryCatch try_catch;
+		cancelled[i].callback->Call(handle_,
+			cancelled[i].reader ? 3 : 1, callbackArgs);
+		if (try_catch.HasCaught()) {
+			node::FatalException(try_catch);
+		}
+	}
+}
+
 /*
  * Thread event loop.
  */
@@ -364,7 +1078,21 @@ Adabas::ThreadEventLoop(void* data)
 #endif // _DEBUG
 
 	Adabas::Thread& thread = *static_cast<Adabas::Thread*>(data);
+	Adabas* self = thread.self;
+
+	self->OpenSessions(thread);
+
+	if (self->m_options.idleTimeoutMs > 0) {
+		uv_timer_start(thread.idleTimer, ThreadOnIdle,
+			self->m_options.idleTimeoutMs, 0);
+	}
 	uv_run(thread.threadLoop, UV_RUN_DEFAULT);
+
+	// Thread is freed in main thread (the message is ignored after
+	// finalization, because main thread closes it).
+	AtomicStore(&thread.exited, 1);
+	uv_async_send(self->m_threadExitedMessage);
+
 	uv_sem_post(&thread.threadExitSemaphore);
 
 #ifdef _DEBUG
@@ -380,8 +1108,8 @@ Adabas::ThreadOnExit(uv_async_t* handle, int status)
 {
 	Adabas::Thread& thread = *static_cast<Adabas::Thread*>(handle->data);
 
-	uv_unref((uv_handle_t*) thread.exitMessage);
-	uv_close((uv_handle_t*) thread.exitMessage, onHandleClosed);
+	thread.self->CloseSessions(thread);
+	closeThreadHandles(thread);
 
 #ifdef _DEBUG
 	fprintf(stderr, "[thread-exit]\n");
@@ -389,205 +1117,2247 @@ Adabas::ThreadOnExit(uv_async_t* handle, int status)
 }
 
 /*
- * Processes message 'exec' in the thread.
+ * Processes idle timeout in the thread: thread leaves the pool when
+ * the pool has more threads than required.
  */
 void
-Adabas::ThreadOnExec(uv_async_t* handle, int status)
+Adabas::ThreadOnIdle(uv_timer_t* handle, int status)
 {
 	Adabas::Thread& thread = *static_cast<Adabas::Thread*>(handle->data);
 	Adabas* self = thread.self;
 
-	while (self->m_requests.size() > 0) {
-		uv_mutex_lock(&requestsMutex);
-		Request request = self->m_requests.front();
-		self->m_requests.pop();
-		uv_mutex_unlock(&requestsMutex);
+	uint32_t numThreads = AtomicLoad(&self->m_numThreads);
+	if (numThreads <= self->m_options.minThreads) {
+		return;
+	}
 
-		// Execute Adabas direct call.
-		Command *commandPtr = request.commandPtr;
-		request.rc = adabas(
-			&commandPtr->m_cb,
-			commandPtr->m_buffers[0],
-			commandPtr->m_buffers[1],
-			commandPtr->m_buffers[2],
-			commandPtr->m_buffers[3],
-			commandPtr->m_buffers[4]);
-
-		uv_mutex_lock(&finishedRequestsMutex);
-		self->m_finishedRequests.push_back(request);
-		uv_mutex_unlock(&finishedRequestsMutex);
-
-		if (!request.callback.IsEmpty()) {
-			thread.execFinishedMessage->data = (void*) &thread;
-			uv_async_send(thread.execFinishedMessage);
-		} else {
-			uv_mutex_lock(&finishedRequestsMutex);
-			uv_cond_signal(&thread.execEndCond);
-			uv_mutex_unlock(&finishedRequestsMutex);
-		}
+	bool leave = thread.requests.Empty() &&
+		AtomicCompareExchange(&self->m_numThreads, numThreads,
+			numThreads - 1);
+	if (leave && !AtomicCompareExchange(&thread.state, THREAD_IDLE,
+		THREAD_EXITING))
+	{
+		// Thread got new request.
+		AtomicAdd(&self->m_numThreads, 1);
+		leave = false;
+	}
+
+	if (!leave) {
+		uv_timer_start(thread.idleTimer, ThreadOnIdle,
+			self->m_options.idleTimeoutMs, 0);
+		return;
+	}
+
+	// Execute requests queued before main thread noticed the state
+	// change (main thread resubmits requests queued after that).
+	uint32_t slotNo;
+	while (thread.requests.Pop(slotNo)) {
+		self->ExecuteRequest(thread, slotNo);
 	}
+
+#ifdef _DEBUG
+	fprintf(stderr, "[thread-idle-exit]\n");
+#endif // _DEBUG
+	closeThreadHandles(thread);
 }
 
 /*
- * Processes message 'exec finished' in main thread.
+ * Takes the request from the thread queue or steals it from the queues
+ * of other threads (in pool thread).
  */
-void
-Adabas::OnExecFinished(uv_async_t* handle, int status)
+bool
+Adabas::PopRequest(Thread& thread, uint32_t& slotNo)
 {
-	v8::HandleScope scope;
-	Thread& thread = *static_cast<Thread*>(handle->data);
-	Adabas* self = thread.self;
-
-	while (self->m_finishedRequests.size() > 0) {
-		uv_mutex_lock(&finishedRequestsMutex);
-		Request request = self->m_finishedRequests.front();
-		self->m_finishedRequests.pop_front();
-		uv_mutex_unlock(&finishedRequestsMutex);
+	if (thread.sessionRequests.Pop(slotNo) ||
+		thread.requests.Pop(slotNo))
+	{
+		return true;
+	}
 
-		v8::Handle<v8::Function> callback;
-		if (!request.callback.IsEmpty()) {
-			callback = request.callback;
-			request.callback.Dispose();
+	size_t numThreads = m_threads.size();
+	for (size_t i = 1; i < numThreads; i++) {
+		Thread* victim = m_threads[(thread.threadNo + i) % numThreads];
+		if (victim->requests.Pop(slotNo)) {
+			thread.steals = thread.steals + 1;
+			return true;
 		}
+	}
 
-		thread.self->Unref();
-		uv_unref((uv_handle_t*) thread.execMessage);
-		uv_unref((uv_handle_t*) thread.execFinishedMessage);
-		thread.busy = false;
+	return false;
+}
 
-		if (!callback.IsEmpty()) {
-			v8::Local<v8::Value> callbackArgs[] = {
-				v8::Number::New(int32_t(request.rc))
-			};
-			v8::TryCatch try_catch;
-			callback->Call(thread.self->handle_, 1, callbackArgs);
+/*
+ * Returns true if the thread has requests of its sessions or any thread
+ * has queued requests.
+ */
+bool
+Adabas::HasRequests(Thread& thread)
+{
+	if (!thread.sessionRequests.Empty()) {
+		return true;
+	}
+	for (size_t threadNo = 0; threadNo < m_threads.size(); threadNo++) {
+		if (!m_threads[threadNo]->requests.Empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Calls Adabas with the control block and buffers of the command, saves
+ * duration of the call in the command and records the call in metrics
+ * and the flight recorder of the calling thread.
+ */
+static int
+CallAdabas(Command* commandPtr, Adabas::CallLog& callLog)
+{
+	uint64_t startTime = uv_hrtime();
+	int rc = adabas(
+		&commandPtr->m_cb,
+		commandPtr->m_buffers[0],
+		commandPtr->m_buffers[1],
+		commandPtr->m_buffers[2],
+		commandPtr->m_buffers[3],
+		commandPtr->m_buffers[4]);
+	commandPtr->m_lastCallTime = uv_hrtime() - startTime;
+
+	const CB_PAR& cb = commandPtr->m_cb;
+	bool physical = CB_PHYS_FILE_NR(&cb);
+	callLog.metrics.Record(reinterpret_cast<const char*>(cb.cb_cmd_code),
+		physical ? cb.alt_cb_db_id : cb.cb_db_id,
+		physical ? cb.alt_cb_file_nr : cb.cb_file_nr,
+		rc == ADA_SUCCESS ? uint16_t(cb.cb_return_code) :
+			uint16_t(Metrics::RESPONSE_CALL_FAILED),
+		commandPtr->m_lastCallTime);
+	callLog.flightRecorder.Record(cb, commandPtr->m_buffers, rc, startTime,
+		commandPtr->m_lastCallTime);
+	return rc;
+}
+
+/*
+ * Executes Adabas direct call of the request and passes the request
+ * to main thread (in pool thread).
+ */
+void
+Adabas::ExecuteRequest(Thread& thread, uint32_t slotNo)
+{
+	Request& request = m_slots[slotNo];
+	uint64_t startTime = uv_hrtime();
+
+	bool timing = m_options.timing;
+	if (timing) {
+		request.times[TIME_DEQUEUED] = startTime;
+		request.wakeUpTime = thread.wakeUpTime;
+	}
+
+	if (!thread.sessions.empty()) {
+		SelectSession(thread, request.session < 0 ? -1 :
+			request.session % m_options.sessionsPerThread);
+	}
+
+	if (timing) {
+		request.times[TIME_CALL_STARTED] = uv_hrtime();
+	}
+
+	Chain* chain = request.chain;
+	if (chain != NULL) {
+		// Commands of the chain are executed back-to-back.
+		for (size_t i = 0; i < chain->commandPtrs.size(); i++) {
+			Command *commandPtr = chain->commandPtrs[i];
+			int rc = CallAdabas(commandPtr, thread.callLog);
+			chain->rcs.push_back(rc);
+			if (chain->stopOnRc && (rc != ADA_SUCCESS ||
+				commandPtr->m_cb.cb_return_code != ADA_NORMAL))
+			{
+				break;
+			}
+		}
+	} else if (request.reader != NULL) {
+		request.rc = request.reader->isnList ?
+			ReadIsnChunk(*request.reader, thread.callLog) :
+			ReadChunk(*request.reader, thread.callLog);
+	} else {
+		Command *commandPtr = request.commandPtr;
+		request.rc = CallAdabas(commandPtr, thread.callLog);
+	}
+
+	uint64_t endTime = uv_hrtime();
+	if (timing) {
+		request.times[TIME_CALL_FINISHED] = endTime;
+		request.times[TIME_COMPLETED] = endTime;
+	}
+	thread.busyTimeNs += endTime - startTime;
+	thread.busyTime = uint32_t(thread.busyTimeNs / 1000000);
+
+	if (request.sync) {
+		uv_sem_post(&m_execEndSemaphore);
+	} else {
+		thread.finishedRequests.Push(slotNo);
+		uv_async_send(m_execFinishedMessage);
+	}
+}
+
+/*
+ * Reads the chunk of records by the command of the reader (in thread).
+ * Records are copied to the chunk one after another, each record has
+ * the length of the record buffer.
+ */
+int
+Adabas::ReadChunk(Reader& reader, CallLog& callLog)
+{
+	Command* commandPtr = reader.commandPtr;
+	size_t recordLength = commandPtr->m_cb.cb_rec_buf_lng;
+
+	uint32_t numRecords = reader.chunkRecords;
+	if (reader.maxRecords > 0 &&
+		reader.maxRecords - reader.numRecords < numRecords)
+	{
+		numRecords = reader.maxRecords - reader.numRecords;
+	}
+
+	reader.chunkIsns.clear();
+	reader.chunkLength = 0;
+	reader.chunkData = static_cast<char*>(
+		malloc(numRecords * recordLength));
+	if (reader.chunkData == NULL) {
+		reader.finished = true;
+		return ADA_SUCCESS;
+	}
+
+	int rc = ADA_SUCCESS;
+	while (reader.chunkIsns.size() < numRecords) {
+		rc = CallAdabas(commandPtr, callLog);
+		if (rc != ADA_SUCCESS ||
+			commandPtr->m_cb.cb_return_code != ADA_NORMAL)
+		{
+			reader.finished = true;
+			break;
+		}
+
+		memcpy(reader.chunkData + reader.chunkLength,
+			commandPtr->m_buffers[1], recordLength);
+		reader.chunkLength += recordLength;
+		reader.chunkIsns.push_back(commandPtr->m_cb.cb_isn);
+	}
+
+	reader.numRecords += reader.chunkIsns.size();
+	if (reader.maxRecords > 0 && reader.numRecords >= reader.maxRecords) {
+		reader.finished = true;
+	}
+
+	return rc;
+}
+
+/*
+ * Reads the page of ISNs by the command of the reader (in thread). First
+ * call executes the search and stores ISN quantity, next calls read the
+ * saved ISN list from the ISN lower limit, which is the last ISN read.
+ * ISNs are copied from the ISN buffer to the chunk.
+ */
+int
+Adabas::ReadIsnChunk(Reader& reader, CallLog& callLog)
+{
+	Command* commandPtr = reader.commandPtr;
+	uint32_t numIsns = commandPtr->m_cb.cb_isn_buf_lng / sizeof(uint32_t);
+
+	reader.chunkLength = 0;
+	reader.chunkData = static_cast<char*>(
+		malloc(numIsns * sizeof(uint32_t)));
+	if (reader.chunkData == NULL) {
+		reader.finished = true;
+		return ADA_SUCCESS;
+	}
+
+	if (reader.numRecords > 0) {
+		commandPtr->m_cb.cb_isn_ll = reader.lastIsn;
+	}
+	int rc = CallAdabas(commandPtr, callLog);
+	if (rc != ADA_SUCCESS || commandPtr->m_cb.cb_return_code != ADA_NORMAL) {
+		reader.finished = true;
+		return rc;
+	}
+	if (reader.numRecords == 0) {
+		reader.isnQuantity = commandPtr->m_cb.cb_isn_quantity;
+	}
+
+	uint32_t limit = reader.isnQuantity;
+	if (reader.maxRecords > 0 && reader.maxRecords < limit) {
+		limit = reader.maxRecords;
+	}
+	if (limit - reader.numRecords < numIsns) {
+		numIsns = limit - reader.numRecords;
+	}
+
+	if (numIsns > 0) {
+		reader.chunkLength = numIsns * sizeof(uint32_t);
+		memcpy(reader.chunkData, commandPtr->m_buffers[4],
+			reader.chunkLength);
+		reader.lastIsn =
+			reinterpret_cast<uint32_t*>(reader.chunkData)[numIsns - 1];
+		reader.numRecords += numIsns;
+	}
+	if (numIsns == 0 || reader.numRecords >= limit) {
+		reader.finished = true;
+	}
+
+	return rc;
+}
+
+/*
+ * Switches Adabas ID of the thread to the session (-1 - default Adabas
+ * ID of the thread).
+ */
+void
+Adabas::SelectSession(Thread& thread, int session)
+{
+	if (thread.currentSession == session) {
+		return;
+	}
+
+	lnk_set_adabas_id(session < 0 ?
+		thread.adabasId : thread.sessions[session].adabasId);
+	thread.currentSession = session;
+}
+
+/*
+ * Opens sessions of the thread with command 'OP' (in pool thread).
+ */
+void
+Adabas::OpenSessions(Thread& thread)
+{
+	if (thread.sessions.empty()) {
+		return;
+	}
+
+	const std::string& recordBuffer = m_options.sessionRecordBuffer;
+	std::vector<char> recordBufferCopy(recordBuffer.begin(),
+		recordBuffer.end());
+
+	for (size_t sessionNo = 0; sessionNo < thread.sessions.size();
+		sessionNo++)
+	{
+		Session& session = thread.sessions[sessionNo];
+		SelectSession(thread, sessionNo);
+
+		CB_PAR cb;
+		memset(&cb, 0, sizeof(CB_PAR));
+		cb.cb_cmd_code[0] = 'O';
+		cb.cb_cmd_code[1] = 'P';
+		CB_SET_FD(&cb, m_options.sessionDbId, 0);
+		cb.cb_rec_buf_lng = recordBufferCopy.size();
+
+		session.rc = adabas(&cb, NULL, recordBufferCopy.empty() ?
+			NULL : &recordBufferCopy[0], NULL, NULL, NULL);
+		if (session.rc == ADA_SUCCESS) {
+			session.rc = cb.cb_return_code;
+		}
+		AtomicStore(&session.opened, 1);
+
+#ifdef _DEBUG
+		fprintf(stderr, "[session-open] %u/%u: %d\n", thread.threadNo,
+			(unsigned int) sessionNo, session.rc);
+#endif // _DEBUG
+	}
+
+	SelectSession(thread, -1);
+}
+
+/*
+ * Closes opened sessions of the thread with command 'CL'
+ * (in pool thread).
+ */
+void
+Adabas::CloseSessions(Thread& thread)
+{
+	for (size_t sessionNo = 0; sessionNo < thread.sessions.size();
+		sessionNo++)
+	{
+		Session& session = thread.sessions[sessionNo];
+		if (!AtomicLoad(&session.opened) || session.rc != ADA_NORMAL) {
+			continue;
+		}
+		SelectSession(thread, sessionNo);
+
+		CB_PAR cb;
+		memset(&cb, 0, sizeof(CB_PAR));
+		cb.cb_cmd_code[0] = 'C';
+		cb.cb_cmd_code[1] = 'L';
+		CB_SET_FD(&cb, m_options.sessionDbId, 0);
+		adabas(&cb, NULL, NULL, NULL, NULL, NULL);
+		AtomicStore(&session.opened, 0);
+	}
+
+	if (!thread.sessions.empty()) {
+		SelectSession(thread, -1);
+	}
+}
+
+/*
+ * Processes message 'exec' in the thread.
+ */
+void
+Adabas::ThreadOnExec(uv_async_t* handle, int status)
+{
+	Adabas::Thread& thread = *static_cast<Adabas::Thread*>(handle->data);
+	Adabas* self = thread.self;
+
+	thread.wakeUps = thread.wakeUps + 1;
+	if (self->m_options.timing) {
+		thread.wakeUpTime = uv_hrtime();
+	}
+
+	for (;;) {
+		uint32_t slotNo;
+		while (self->PopRequest(thread, slotNo)) {
+			self->ExecuteRequest(thread, slotNo);
+		}
+
+		// Requests submitted while the thread was busy are not followed
+		// by the message, so the queues are checked after state change.
+		AtomicExchange(&thread.state, THREAD_IDLE);
+		if (!self->HasRequests(thread) ||
+			!AtomicCompareExchange(&thread.state, THREAD_IDLE,
+				THREAD_BUSY))
+		{
+			break;
+		}
+	}
+
+	if (self->m_options.idleTimeoutMs > 0) {
+		uv_timer_start(thread.idleTimer, ThreadOnIdle,
+			self->m_options.idleTimeoutMs, 0);
+	}
+}
+
+/*
+ * Calls callbacks of the requests finished by the thread
+ * (in main thread).
+ */
+void
+Adabas::ProcessFinishedRequests(Thread* thread)
+{
+	// Callback may close the object, then the rest of requests is left
+	// to Finalize().
+	bool finalized = m_finalized;
+
+	uint32_t slotNo;
+	while (thread->finishedRequests.Pop(slotNo)) {
+		Request& request = m_slots[slotNo];
+		v8::Local<v8::Value> timing;
+		if (m_options.timing) {
+			timing = RecordTiming(request);
+		}
+
+		if (request.reader != NULL) {
+			ProcessReaderChunk(slotNo);
+			if (m_finalized != finalized) {
+				return;
+			}
+			continue;
+		}
+
+		// Results of the batch are collected for the single callback.
+		Batch* batch = request.batch;
+		if (batch != NULL) {
+			batch->indexes.push_back(request.index);
+			batch->rcs.push_back(request.rc);
+			request.batch = NULL;
+			m_freeSlots.push_back(slotNo);
+			if (batch->indexes.size() == batch->numRequests) {
+				m_finishedBatches.push_back(batch);
+			}
+			continue;
+		}
+
+		Chain* chain = request.chain;
+		if (chain != NULL) {
+			request.chain = NULL;
+			m_freeSlots.push_back(slotNo);
+			ProcessFinishedChain(chain);
+			if (m_finalized != finalized) {
+				return;
+			}
+			continue;
+		}
+
+		v8::Local<v8::Function> callback =
+			v8::Local<v8::Function>::New(request.callback);
+		request.callback.Dispose();
+		request.callback.Clear();
+		request.command.Dispose();
+		request.command.Clear();
+		int rc = request.rc;
+		m_freeSlots.push_back(slotNo);
+
+		Unref();
+		if (--m_pendingCallbacks == 0) {
+			uv_unref((uv_handle_t*) m_execFinishedMessage);
+		}
+
+		v8::Local<v8::Value> callbackArgs[] = {
+			v8::Number::New(int32_t(rc)),
+			timing
+		};
+		v8::TryCatch try_catch;
+		callback->Call(handle_, timing.IsEmpty() ? 1 : 2, callbackArgs);
+		if (try_catch.HasCaught()) {
+			node::FatalException(try_catch);
+		}
+		if (m_finalized != finalized) {
+			return;
+		}
+	}
+}
+
+/*
+ * Calls callbacks of the finished batches with array of results
+ * '{ index, rc }' in order of completion (in main thread).
+ */
+void
+Adabas::ProcessFinishedBatches(void)
+{
+	// Batch is removed from the list before its callback, which may
+	// close the object.
+	bool finalized = m_finalized;
+	while (!m_finishedBatches.empty() && m_finalized == finalized) {
+		Batch* batch = m_finishedBatches.front();
+		m_finishedBatches.erase(m_finishedBatches.begin());
+
+		v8::Local<v8::Array> results = v8::Array::New(batch->numRequests);
+		for (uint32_t i = 0; i < batch->numRequests; i++) {
+			v8::Local<v8::Object> result = v8::Object::New();
+			result->Set(indexSymbol,
+				v8::Integer::NewFromUnsigned(batch->indexes[i]));
+			result->Set(rcSymbol, v8::Number::New(int32_t(batch->rcs[i])));
+			results->Set(i, result);
+		}
+
+		v8::Local<v8::Function> callback =
+			v8::Local<v8::Function>::New(batch->callback);
+		batch->callback.Dispose();
+		batch->commands.Dispose();
+		delete batch;
+
+		Unref();
+		if (--m_pendingCallbacks == 0) {
+			uv_unref((uv_handle_t*) m_execFinishedMessage);
+		}
+
+		v8::Local<v8::Value> callbackArgs[] = {
+			v8::Local<v8::Value>::New(v8::Null()),
+			results
+		};
+		v8::TryCatch try_catch;
+		callback->Call(handle_, 2, callbackArgs);
+		if (try_catch.HasCaught()) {
+			node::FatalException(try_catch);
+		}
+	}
+}
+
+/*
+ * Calls callback of the finished chain with array of result codes of
+ * executed commands (in main thread).
+ */
+void
+Adabas::ProcessFinishedChain(Chain* chain)
+{
+	v8::Local<v8::Array> results = v8::Array::New(chain->rcs.size());
+	for (uint32_t i = 0; i < chain->rcs.size(); i++) {
+		results->Set(i, v8::Number::New(int32_t(chain->rcs[i])));
+	}
+
+	v8::Local<v8::Function> callback =
+		v8::Local<v8::Function>::New(chain->callback);
+	chain->callback.Dispose();
+	chain->commands.Dispose();
+	delete chain;
+
+	Unref();
+	if (--m_pendingCallbacks == 0) {
+		uv_unref((uv_handle_t*) m_execFinishedMessage);
+	}
+
+	v8::Local<v8::Value> callbackArgs[] = {
+		v8::Local<v8::Value>::New(v8::Null()),
+		results
+	};
+	v8::TryCatch try_catch;
+	callback->Call(handle_, 2, callbackArgs);
+	if (try_catch.HasCaught()) {
+		node::FatalException(try_catch);
+	}
+}
+
+/*
+ * Frees the chunk of records passed to Buffer.
+ */
+static void
+FreeChunk(char* data, void* hint)
+{
+	free(data);
+}
+
+/*
+ * Passes the chunk of records read by the reader to callback
+ * onChunk(buffer, isns) (ISN list reader: onChunk(isns)) and submits the
+ * request for the next chunk, or calls onDone(err, rc, numRecords) when
+ * reading is finished (in main thread). Reader keeps the request slot
+ * until it is finished.
+ */
+void
+Adabas::ProcessReaderChunk(uint32_t slotNo)
+{
+	Request& request = m_slots[slotNo];
+	Reader* reader = request.reader;
+
+	v8::Local<v8::Value> chunk;
+	v8::Local<v8::Value> isns;
+	bool outOfMemory = reader->chunkData == NULL;
+	if (reader->chunkLength > 0) {
+		// Chunk memory is passed to Buffer without copying.
+		node::Buffer* buffer = node::Buffer::New(reader->chunkData,
+			reader->chunkLength, FreeChunk, NULL);
+		chunk = v8::Local<v8::Object>::New(buffer->handle_);
+
+		if (reader->isnList) {
+			chunk = Command::NewIsnArray(buffer->handle_,
+				uint32_t(reader->chunkLength / sizeof(uint32_t)));
+		} else {
+			v8::Local<v8::Array> isnArray =
+				v8::Array::New(reader->chunkIsns.size());
+			for (uint32_t i = 0; i < reader->chunkIsns.size(); i++) {
+				isnArray->Set(i, v8::Integer::NewFromUnsigned(
+					reader->chunkIsns[i]));
+			}
+			isns = isnArray;
+		}
+	} else {
+		free(reader->chunkData);
+	}
+	reader->chunkData = NULL;
+	int numChunkArgs = reader->isnList ? 1 : 2;
+	const char* syscall = reader->isnList ? "ReadIsns" : "ReadAll";
+
+	v8::Local<v8::Function> onChunk =
+		v8::Local<v8::Function>::New(reader->onChunk);
+
+	if (reader->finished || m_finalized) {
+		v8::Local<v8::Function> onDone =
+			v8::Local<v8::Function>::New(reader->onDone);
+		int rc = request.rc;
+		uint32_t numRecords = reader->numRecords;
+
+		reader->onChunk.Dispose();
+		reader->onDone.Dispose();
+		reader->command.Dispose();
+		delete reader;
+		request.reader = NULL;
+		m_freeSlots.push_back(slotNo);
+
+		Unref();
+		if (--m_pendingCallbacks == 0) {
+			uv_unref((uv_handle_t*) m_execFinishedMessage);
+		}
+
+		if (!chunk.IsEmpty()) {
+			v8::Local<v8::Value> chunkArgs[] = { chunk, isns };
+			v8::TryCatch try_catch;
+			onChunk->Call(handle_, numChunkArgs, chunkArgs);
 			if (try_catch.HasCaught()) {
 				node::FatalException(try_catch);
 			}
 		}
+
+		v8::Local<v8::Value> doneArgs[] = {
+			outOfMemory ?
+				node::ErrnoException(ENOMEM, syscall) :
+				v8::Local<v8::Value>::New(v8::Null()),
+			v8::Number::New(int32_t(rc)),
+			v8::Integer::NewFromUnsigned(numRecords)
+		};
+		v8::TryCatch try_catch;
+		onDone->Call(handle_, 3, doneArgs);
+		if (try_catch.HasCaught()) {
+			node::FatalException(try_catch);
+		}
+		return;
+	}
+
+	// Next chunk is read while the current chunk is processed, paused
+	// reader reads ahead only 'prefetch' chunks.
+	if (reader->paused) {
+		reader->aheadChunks++;
+	}
+	reader->inFlight = !reader->paused ||
+		reader->aheadChunks < reader->prefetch;
+	if (reader->inFlight) {
+		SubmitRequest(slotNo);
+	}
+
+	if (!chunk.IsEmpty()) {
+		v8::Local<v8::Value> chunkArgs[] = { chunk, isns };
+		v8::TryCatch try_catch;
+		v8::Local<v8::Value> result =
+			onChunk->Call(handle_, numChunkArgs, chunkArgs);
+		if (try_catch.HasCaught()) {
+			node::FatalException(try_catch);
+		}
+
+		// Consumer returns false when it doesn't want more chunks.
+		if (!result.IsEmpty() && result->IsFalse() && !reader->paused) {
+			reader->paused = true;
+			reader->aheadChunks = 0;
+		}
+	}
+}
+
+/*
+ * Records phases of the finished request into histograms (in main thread).
+ * Returns breakdown of the request in microseconds.
+ */
+v8::Local<v8::Value>
+Adabas::RecordTiming(Request& request)
+{
+	uint64_t* times = request.times;
+	times[TIME_CALLBACK] = uv_hrtime();
+
+	// Request waits for the thread wake up, if the thread was woken up
+	// after the request was submitted.
+	uint64_t wokenTime = request.wakeUpTime > times[TIME_SUBMITTED] ?
+		request.wakeUpTime : times[TIME_SUBMITTED];
+	if (wokenTime > times[TIME_DEQUEUED]) {
+		wokenTime = times[TIME_DEQUEUED];
+	}
+
+	uint64_t phases[NUM_PHASES];
+	phases[PHASE_WAKEUP] = wokenTime - times[TIME_SUBMITTED];
+	phases[PHASE_QUEUE] = times[TIME_DEQUEUED] - wokenTime;
+	phases[PHASE_DISPATCH] =
+		times[TIME_CALL_STARTED] - times[TIME_DEQUEUED];
+	phases[PHASE_CALL] =
+		times[TIME_CALL_FINISHED] - times[TIME_CALL_STARTED];
+	phases[PHASE_COMPLETION] =
+		times[TIME_CALLBACK] - times[TIME_COMPLETED];
+	phases[PHASE_TOTAL] = times[TIME_CALLBACK] - times[TIME_SUBMITTED];
+	phases[PHASE_COMMAND_TIME] = request.commandPtr->m_cb.cb_cmd_time;
+
+	v8::Local<v8::Object> breakdown = v8::Object::New();
+	for (int phase = 0; phase < NUM_PHASES; phase++) {
+		m_histograms[phase].Record(phases[phase]);
+		breakdown->Set(v8::String::NewSymbol(phaseNames[phase]),
+			v8::Number::New(phase == PHASE_COMMAND_TIME ?
+				double(phases[phase]) : double(phases[phase]) / 1000));
+	}
+	return breakdown;
+}
+
+/*
+ * Sums metrics of Adabas calls of all threads (in main thread).
+ */
+void
+Adabas::CollectMetrics(Metrics::SeriesMap& series) const
+{
+	m_callLog.metrics.Collect(series);
+	for (size_t threadNo = 0; threadNo < m_threads.size(); threadNo++) {
+		m_threads[threadNo]->callLog.metrics.Collect(series);
+	}
+}
+
+/*
+ * Returns true if the call was started before the other call.
+ */
+static bool
+CallStartedBefore(const FlightRecorder::Call& call,
+	const FlightRecorder::Call& other)
+{
+	return call.time < other.time;
+}
+
+static bool
+SlowCallStartedBefore(const FlightRecorder::SlowCall& slowCall,
+	const FlightRecorder::SlowCall& other)
+{
+	return slowCall.call.time < other.call.time;
+}
+
+/*
+ * Collects calls from flight recorders and slow logs of all threads
+ * sorted by start time (in main thread).
+ */
+void
+Adabas::CollectCalls(std::vector<FlightRecorder::Call>& calls,
+	std::vector<FlightRecorder::SlowCall>& slowCalls) const
+{
+	m_callLog.flightRecorder.Collect(calls);
+	m_callLog.flightRecorder.CollectSlow(slowCalls);
+	for (size_t threadNo = 0; threadNo < m_threads.size(); threadNo++) {
+		m_threads[threadNo]->callLog.flightRecorder.Collect(calls);
+		m_threads[threadNo]->callLog.flightRecorder.CollectSlow(slowCalls);
+	}
+	std::sort(calls.begin(), calls.end(), CallStartedBefore);
+	std::sort(slowCalls.begin(), slowCalls.end(), SlowCallStartedBefore);
+}
+
+/*
+ * Returns text of flight recorders and slow logs, a line per call.
+ */
+std::string
+Adabas::DumpFlightRecorders(void) const
+{
+	std::vector<FlightRecorder::Call> calls;
+	std::vector<FlightRecorder::SlowCall> slowCalls;
+	CollectCalls(calls, slowCalls);
+	uint64_t now = uv_hrtime();
+
+	std::string text = "Flight recorder:\n";
+	for (size_t i = 0; i < calls.size(); i++) {
+		text += FlightRecorder::Format(calls[i], now);
+		text += "\n";
+	}
+	text += "Slow log:\n";
+	for (size_t i = 0; i < slowCalls.size(); i++) {
+		text += FlightRecorder::FormatSlow(slowCalls[i], now);
+		text += "\n";
+	}
+	return text;
+}
+
+/*
+ * Returns slot number of the reader of the command, or number of slots
+ * when the command is not read (in main thread).
+ */
+uint32_t
+Adabas::FindReader(Command* commandPtr)
+{
+	for (uint32_t slotNo = 0; slotNo < m_slots.size(); slotNo++) {
+		Reader* reader = m_slots[slotNo].reader;
+		if (reader != NULL && reader->commandPtr == commandPtr) {
+			return slotNo;
+		}
+	}
+	return m_slots.size();
+}
+
+/*
+ * Processes message 'exec finished' in main thread.
+ */
+void
+Adabas::OnExecFinished(uv_async_t* handle, int status)
+{
+	v8::HandleScope scope;
+	Adabas* self = static_cast<Adabas*>(handle->data);
+
+	if (self->m_finalized) {
+		self->FinishRequests();
+		return;
+	}
+
+	for (size_t threadNo = 0; threadNo < self->m_threads.size();
+		threadNo++)
+	{
+		self->ProcessFinishedRequests(self->m_threads[threadNo]);
+		if (self->m_finalized) {
+			return;
+		}
+	}
+	self->ProcessFinishedBatches();
+	if (self->m_finalized) {
+		return;
+	}
+
+	self->SubmitWaitingRequests();
+	self->CheckLowWaterMark();
+}
+
+/*
+ * Frees threads which left the pool by idle timeout (in main thread).
+ */
+void
+Adabas::OnThreadExited(uv_async_t* handle, int status)
+{
+	Adabas* self = static_cast<Adabas*>(handle->data);
+
+	for (size_t threadNo = 0; threadNo < self->m_threads.size();
+		threadNo++)
+	{
+		Thread* thread = self->m_threads[threadNo];
+		if (AtomicLoad(&thread->exited) &&
+			AtomicLoad(&thread->state) == THREAD_EXITING)
+		{
+			self->StopThread(thread);
+		}
+	}
+}
+
+/*
+ * Takes the sample of gauges by the sampling timer (in main thread).
+ */
+void
+Adabas::OnSample(uv_timer_t* handle, int status)
+{
+	Adabas* self = static_cast<Adabas*>(handle->data);
+	self->TakeSample();
+}
+
+/*
+ * Writes flight recorders to stderr on signal SIGUSR2 (in main thread).
+ */
+void
+Adabas::OnDumpSignal(uv_signal_t* handle, int signum)
+{
+	Adabas* self = static_cast<Adabas*>(handle->data);
+	std::string text = self->DumpFlightRecorders();
+	fwrite(text.data(), 1, text.size(), stderr);
+	fflush(stderr);
+}
+
+/*
+ * Closes the Adabas instance.
+ */
+v8::Handle<v8::Value>
+Adabas::Close(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+	self->Finalize();
+	return v8::Undefined();
+}
+
+/*
+ * Executes the application callback if server is busy.
+ */
+static void
+CallBusyCallback(v8::Handle<v8::Object> self,
+	v8::Handle<v8::Function> callback)
+{
+#if _DEBUG
+	fprintf(stderr, "[busy]\n");
+#endif // _DEBUG
+
+	if (callback.IsEmpty()) {
+		return;
+	}
+
+	v8::Local<v8::Value> exception =
+		node::ErrnoException(EBUSY, "ExecRequest");
+	v8::Local<v8::Value> callbackArgs[] = { exception };
+	v8::TryCatch try_catch;
+	callback->Call(self, 1, callbackArgs);
+	if (try_catch.HasCaught()) {
+		node::FatalException(try_catch);
+	}
+}
+
+/*
+ * Wakes up the thread after the request is queued (in main thread).
+ * Flag 'wakeUp' is set when the thread must be woken up.
+ */
+void
+Adabas::WakeUpThread(Thread* thread, bool wakeUp)
+{
+	AtomicFence();
+
+	for (;;) {
+		if (wakeUp) {
+			// Send message 'exec' to the thread.
+			uv_async_send(thread->execMessage);
+			return;
+		}
+
+		// Busy thread checks the queues before it becomes idle.
+		uint32_t state = AtomicLoad(&thread->state);
+		if (state == THREAD_BUSY) {
+			return;
+		}
+		if (state == THREAD_IDLE) {
+			wakeUp = AtomicCompareExchange(&thread->state,
+				THREAD_IDLE, THREAD_BUSY);
+			continue;
+		}
+
+		// Thread leaves the pool: resubmit requests it did not take.
+		uint32_t queuedSlotNo;
+		while (thread->requests.Pop(queuedSlotNo)) {
+			SubmitRequest(queuedSlotNo);
+		}
+		return;
+	}
+}
+
+/*
+ * Appends filled request slot to the queue of the session thread or
+ * the selected thread (in main thread).
+ */
+void
+Adabas::SubmitRequest(uint32_t slotNo)
+{
+	if (m_options.timing) {
+		m_slots[slotNo].times[TIME_SUBMITTED] = uv_hrtime();
+	}
+
+	int session = m_slots[slotNo].session;
+	if (session >= 0) {
+		Thread* thread =
+			m_threads[session / m_options.sessionsPerThread];
+		thread->sessionRequests.Push(slotNo);
+		WakeUpThread(thread, false);
+		return;
+	}
+
+	bool wakeUp;
+	Thread* thread = SelectThread(wakeUp);
+	thread->requests.Push(slotNo);
+	WakeUpThread(thread, wakeUp);
+}
+
+/*
+ * Fills the free request slot (in main thread).
+ */
+uint32_t
+Adabas::PrepareRequest(Command* commandPtr,
+	v8::Handle<v8::Function> callback)
+{
+	uint32_t slotNo = m_freeSlots.back();
+	m_freeSlots.pop_back();
+
+	Request& request = m_slots[slotNo];
+	request.commandPtr = commandPtr;
+	request.rc = 0;
+	request.sync = callback.IsEmpty();
+	request.batch = NULL;
+	request.chain = NULL;
+	request.reader = NULL;
+	request.session = commandPtr->m_session;
+	if (!callback.IsEmpty()) {
+		request.command =
+			v8::Persistent<v8::Object>::New(commandPtr->handle_);
+		request.callback = v8::Persistent<v8::Function>::New(callback);
+	}
+
+	return slotNo;
+}
+
+/*
+ * Submits waiting requests to the free slots (in main thread).
+ */
+void
+Adabas::SubmitWaitingRequests(void)
+{
+	while (!m_waitingRequests.empty() && !m_freeSlots.empty()) {
+		WaitingRequest& waitingRequest = m_waitingRequests.front();
+
+		// Request takes over the command and callback handles.
+		uint32_t slotNo = m_freeSlots.back();
+		m_freeSlots.pop_back();
+
+		Request& request = m_slots[slotNo];
+		request.commandPtr = waitingRequest.commandPtr;
+		request.rc = 0;
+		request.sync = false;
+		request.batch = NULL;
+		request.chain = NULL;
+		request.reader = NULL;
+		request.session = waitingRequest.commandPtr->m_session;
+		request.command = waitingRequest.command;
+		request.callback = waitingRequest.callback;
+
+		m_waitingRequests.pop_front();
+		SubmitRequest(slotNo);
+	}
+}
+
+/*
+ * Returns false and arms event 'drain' when number of requests in flight
+ * reaches high watermark.
+ */
+bool
+Adabas::CheckHighWaterMark(void)
+{
+	if (NumRequestsInFlight() >= m_options.highWaterMark ||
+		!m_waitingRequests.empty())
+	{
+		m_needDrain = true;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Emits event 'drain' when number of requests in flight falls to low
+ * watermark after high watermark was reached.
+ */
+void
+Adabas::CheckLowWaterMark(void)
+{
+	if (!m_needDrain || !m_waitingRequests.empty() ||
+		NumRequestsInFlight() > m_options.lowWaterMark)
+	{
+		return;
+	}
+	m_needDrain = false;
+
+	v8::Local<v8::Value> emit = handle_->Get(emitSymbol);
+	if (!emit->IsFunction()) {
+		return;
+	}
+
+	v8::Local<v8::Value> emitArgs[] = {
+		v8::Local<v8::Value>::New(drainSymbol)
+	};
+	v8::TryCatch try_catch;
+	v8::Local<v8::Function>::Cast(emit)->Call(handle_, 1, emitArgs);
+	if (try_catch.HasCaught()) {
+		node::FatalException(try_catch);
+	}
+}
+
+/*
+ * Executes Adabas request asyncronously (using thread pool).
+ * Returns false when the request is rejected or when the application
+ * should wait for event 'drain'.
+ */
+v8::Handle<v8::Value>
+Adabas::Exec(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	unsigned int numArgs = args.Length();
+	if (numArgs < 1 || numArgs > 2) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	if (self->m_finalized) {
+		return V8_ERROR("database is closed");
+	}
+
+	Command* commandPtr = Command::FromValue(args[0]);
+	if (commandPtr == NULL) {
+		return V8_ERROR(
+			"first argument must be an Adabas control block");
+	}
+	if (commandPtr->m_session >= self->NumSessions()) {
+		return V8_ERROR("invalid session of the command");
+	}
+
+	v8::Handle<v8::Function> callback;
+	if (numArgs == 2) {
+		if (!args[1]->IsFunction()) {
+			return V8_ERROR("second argument must be a callback");
+		}
+		callback = v8::Handle<v8::Function>::Cast(args[1]);
+	}
+
+	// Asynchronous requests wait for the free slot in the wait queue,
+	// if it is not full (and don't overtake already waiting requests).
+	if (self->m_freeSlots.empty() ||
+		(!callback.IsEmpty() && !self->m_waitingRequests.empty()))
+	{
+		if (callback.IsEmpty() || self->m_waitingRequests.size() >=
+			self->m_options.waitQueue)
+		{
+			self->m_busyRejections++;
+			CallBusyCallback(self->handle_, callback);
+			return scope.Close(v8::False());
+		}
+
+		WaitingRequest waitingRequest;
+		waitingRequest.commandPtr = commandPtr;
+		waitingRequest.command =
+			v8::Persistent<v8::Object>::New(commandPtr->handle_);
+		waitingRequest.callback =
+			v8::Persistent<v8::Function>::New(callback);
+		self->m_waitingRequests.push_back(waitingRequest);
+
+		self->Ref();
+		if (self->m_pendingCallbacks++ == 0) {
+			uv_ref((uv_handle_t*) self->m_execFinishedMessage);
+		}
+
+		self->m_needDrain = true;
+		return scope.Close(v8::False());
+	}
+
+	uint32_t slotNo = self->PrepareRequest(commandPtr, callback);
+	Request& request = self->m_slots[slotNo];
+
+	// Increase reference counters.
+	if (!callback.IsEmpty()) {
+		self->Ref();
+		if (self->m_pendingCallbacks++ == 0) {
+			uv_ref((uv_handle_t*) self->m_execFinishedMessage);
+		}
+	}
+
+	self->SubmitRequest(slotNo);
+
+	// Wait sync execution semaphore if callback is not defined.
+	if (callback.IsEmpty()) {
+		uv_sem_wait(&self->m_execEndSemaphore);
+		if (self->m_options.timing) {
+			self->RecordTiming(request);
+		}
+
+		int rc = request.rc;
+		self->m_freeSlots.push_back(slotNo);
+
+		// Return result code.
+		return scope.Close(v8::Number::New(int32_t(rc)));
+	}
+
+	return scope.Close(v8::Boolean::New(self->CheckHighWaterMark()));
+}
+
+/*
+ * Executes Adabas request syncronously in the calling thread, without
+ * the round trip through the thread pool.
+ */
+v8::Handle<v8::Value>
+Adabas::ExecSync(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 1) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	if (self->m_finalized) {
+		return V8_ERROR("database is closed");
+	}
+
+	Command* commandPtr = Command::FromValue(args[0]);
+	if (commandPtr == NULL) {
+		return V8_ERROR(
+			"first argument must be an Adabas control block");
+	}
+
+	// Sessions are bound to the pool threads.
+	if (commandPtr->m_session >= 0) {
+		return scope.Close(Exec(args));
+	}
+
+	int rc = CallAdabas(commandPtr, self->m_callLog);
+
+	return scope.Close(v8::Number::New(int32_t(rc)));
+}
+
+/*
+ * Executes array of Adabas requests asyncronously and calls the callback
+ * once, when all requests are finished: callback(err, results), where
+ * results is array of '{ index, rc }' in order of completion. Batch
+ * larger than the queue depth can never be submitted and is an error.
+ */
+v8::Handle<v8::Value>
+Adabas::ExecMany(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 2) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	if (self->m_finalized) {
+		return V8_ERROR("database is closed");
+	}
+
+	if (!args[0]->IsArray()) {
+		return V8_ERROR("first argument must be an array of commands");
+	}
+	v8::Local<v8::Array> commands = v8::Local<v8::Array>::Cast(args[0]);
+
+	if (!args[1]->IsFunction()) {
+		return V8_ERROR("second argument must be a callback");
+	}
+	v8::Local<v8::Function> callback =
+		v8::Local<v8::Function>::Cast(args[1]);
+
+	uint32_t numRequests = commands->Length();
+	if (numRequests > self->m_options.queueDepth) {
+		return V8_ERROR("number of commands exceeds queue depth");
+	}
+	std::vector<Command*> commandPtrs(numRequests);
+	for (uint32_t i = 0; i < numRequests; i++) {
+		commandPtrs[i] = Command::FromValue(commands->Get(i));
+		if (commandPtrs[i] == NULL) {
+			return V8_ERROR(
+				"array must contain Adabas control blocks");
+		}
+		if (commandPtrs[i]->m_session >= self->NumSessions()) {
+			return V8_ERROR("invalid session of the command");
+		}
+	}
+
+	if (numRequests > self->m_freeSlots.size() ||
+		!self->m_waitingRequests.empty())
+	{
+		self->m_busyRejections++;
+		CallBusyCallback(self->handle_, callback);
+		return scope.Close(v8::False());
+	}
+
+	Batch* batch = new Batch();
+	batch->callback = v8::Persistent<v8::Function>::New(callback);
+	batch->commands = v8::Persistent<v8::Object>::New(commands);
+	batch->numRequests = numRequests;
+	batch->indexes.reserve(numRequests);
+	batch->rcs.reserve(numRequests);
+
+	self->Ref();
+	if (self->m_pendingCallbacks++ == 0) {
+		uv_ref((uv_handle_t*) self->m_execFinishedMessage);
+	}
+
+	if (numRequests == 0) {
+		self->m_finishedBatches.push_back(batch);
+		uv_async_send(self->m_execFinishedMessage);
+		return scope.Close(v8::True());
+	}
+
+	for (uint32_t i = 0; i < numRequests; i++) {
+		uint32_t slotNo = self->m_freeSlots.back();
+		self->m_freeSlots.pop_back();
+
+		Request& request = self->m_slots[slotNo];
+		request.commandPtr = commandPtrs[i];
+		request.rc = 0;
+		request.sync = false;
+		request.batch = batch;
+		request.index = i;
+		request.chain = NULL;
+		request.reader = NULL;
+		request.session = commandPtrs[i]->m_session;
+
+		self->SubmitRequest(slotNo);
+	}
+
+	return scope.Close(v8::Boolean::New(self->CheckHighWaterMark()));
+}
+
+/*
+ * Executes array of Adabas requests one after another by the single
+ * request of the thread pool: execChain(commands[, options], callback).
+ * Option 'stopOnRc' stops the chain at the first command with non-normal
+ * response code. Callback receives (err, rcs), where rcs is array of
+ * result codes of executed commands.
+ */
+v8::Handle<v8::Value>
+Adabas::ExecChain(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	unsigned int numArgs = args.Length();
+	if (numArgs < 2 || numArgs > 3) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	if (self->m_finalized) {
+		return V8_ERROR("database is closed");
+	}
+
+	if (!args[0]->IsArray()) {
+		return V8_ERROR("first argument must be an array of commands");
+	}
+	v8::Local<v8::Array> commands = v8::Local<v8::Array>::Cast(args[0]);
+
+	bool stopOnRc = false;
+	if (numArgs == 3) {
+		if (!args[1]->IsObject()) {
+			return V8_ERROR("second argument must be an options object");
+		}
+		stopOnRc = args[1]->ToObject()->Get(
+			v8::String::NewSymbol("stopOnRc"))->BooleanValue();
+	}
+
+	if (!args[numArgs - 1]->IsFunction()) {
+		return V8_ERROR("last argument must be a callback");
+	}
+	v8::Local<v8::Function> callback =
+		v8::Local<v8::Function>::Cast(args[numArgs - 1]);
+
+	uint32_t numCommands = commands->Length();
+	if (numCommands == 0) {
+		return V8_ERROR("array of commands is empty");
+	}
+
+	// All commands of the chain are executed in the same session.
+	std::vector<Command*> commandPtrs(numCommands);
+	for (uint32_t i = 0; i < numCommands; i++) {
+		commandPtrs[i] = Command::FromValue(commands->Get(i));
+		if (commandPtrs[i] == NULL) {
+			return V8_ERROR(
+				"array must contain Adabas control blocks");
+		}
+		if (commandPtrs[i]->m_session != commandPtrs[0]->m_session) {
+			return V8_ERROR(
+				"commands of the chain must have the same session");
+		}
+	}
+	if (commandPtrs[0]->m_session >= self->NumSessions()) {
+		return V8_ERROR("invalid session of the command");
+	}
+
+	if (self->m_freeSlots.empty() || !self->m_waitingRequests.empty()) {
+		self->m_busyRejections++;
+		CallBusyCallback(self->handle_, callback);
+		return scope.Close(v8::False());
 	}
+
+	Chain* chain = new Chain();
+	chain->callback = v8::Persistent<v8::Function>::New(callback);
+	chain->commands = v8::Persistent<v8::Object>::New(commands);
+	chain->commandPtrs.swap(commandPtrs);
+	chain->stopOnRc = stopOnRc;
+	chain->rcs.reserve(numCommands);
+
+	self->Ref();
+	if (self->m_pendingCallbacks++ == 0) {
+		uv_ref((uv_handle_t*) self->m_execFinishedMessage);
+	}
+
+	uint32_t slotNo = self->m_freeSlots.back();
+	self->m_freeSlots.pop_back();
+
+	Request& request = self->m_slots[slotNo];
+	request.commandPtr = chain->commandPtrs[0];
+	request.rc = 0;
+	request.sync = false;
+	request.batch = NULL;
+	request.chain = chain;
+	request.reader = NULL;
+	request.session = chain->commandPtrs[0]->m_session;
+
+	self->SubmitRequest(slotNo);
+
+	return scope.Close(v8::Boolean::New(self->CheckHighWaterMark()));
 }
 
 /*
- * Closes the Adabas instance.
+ * Reads records by the command (L2, L3, ...) until the end of file or
+ * error: readAll(command[, options], onChunk, onDone). Thread repeats
+ * the command itself and passes records by chunks: onChunk(buffer, isns),
+ * where buffer contains records of the record buffer length one after
+ * another. Options: 'maxRecords' (0 - unlimited), 'chunkRecords' (records
+ * per chunk, default 100), 'prefetch' (chunks read ahead while the reader
+ * is paused, default 1). Reader pauses when onChunk() returns false and
+ * continues after resumeRead(command). Callback onDone(err, rc, numRecords)
+ * is called at the end, response code of the last command remains in the
+ * command.
  */
 v8::Handle<v8::Value>
-Adabas::Close(const v8::Arguments& args)
+Adabas::ReadAll(const v8::Arguments& args)
 {
-	v8::HandleScope scope;
 	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
-	self->Finalize();
-	return v8::Undefined();
+	return self->StartReader(args, false);
 }
 
 /*
- * Executes Adabas request asyncronously (using thread pool).
+ * Reads ISN list of the search (S1, S2, ...) page by page:
+ * readIsns(command[, options], onIsns, onDone). Command must have the
+ * ISN buffer and the command ID (Adabas saves ISN list), thread repeats
+ * the command with the ISN lower limit set to the last ISN read. Callback
+ * onIsns(isns) receives ISNs as array of unsigned 32-bit integers
+ * (view of the page, not a copy). Options: 'maxIsns' (0 - unlimited) and
+ * 'prefetch', pausing and onDone(err, rc, numIsns) are the same as in
+ * readAll().
  */
 v8::Handle<v8::Value>
-Adabas::Exec(const v8::Arguments& args)
+Adabas::ReadIsns(const v8::Arguments& args)
 {
-        v8::HandleScope scope;
 	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+	return self->StartReader(args, true);
+}
+
+/*
+ * Starts reader of records or ISN list (see readAll() and readIsns()).
+ */
+v8::Handle<v8::Value>
+Adabas::StartReader(const v8::Arguments& args, bool isnList)
+{
+	v8::HandleScope scope;
+	Adabas* self = this;
 
 	unsigned int numArgs = args.Length();
-        if (numArgs < 1 || numArgs > 2) {
-                return V8_ERROR("wrong number of arguments");
- 	}
+	if (numArgs < 3 || numArgs > 4) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	if (self->m_finalized) {
+		return V8_ERROR("database is closed");
+	}
+
+	Command* commandPtr = Command::FromValue(args[0]);
+	if (commandPtr == NULL) {
+		return V8_ERROR(
+			"first argument must be an Adabas control block");
+	}
+	if (commandPtr->m_session >= self->NumSessions()) {
+		return V8_ERROR("invalid session of the command");
+	}
+	if (isnList && (commandPtr->m_buffers[4] == NULL ||
+		commandPtr->m_cb.cb_isn_buf_lng < sizeof(uint32_t)))
+	{
+		return V8_ERROR("command must have the ISN buffer");
+	}
+	if (!isnList && (commandPtr->m_buffers[1] == NULL ||
+		commandPtr->m_cb.cb_rec_buf_lng == 0))
+	{
+		return V8_ERROR("command must have the record buffer");
+	}
+
+	if (self->FindReader(commandPtr) != self->m_slots.size()) {
+		return V8_ERROR("command is already read");
+	}
 
-	Command* commandPtr = NULL;
-	if (args[0]->IsObject()) {
-		v8::Handle<v8::Object> commandObject = args[0]->ToObject();
-		std::string constructorName(*v8::String::Utf8Value(
-			commandObject->GetConstructorName()));
-		if (constructorName == "Command") {
-			commandPtr = node::ObjectWrap::Unwrap<Command>(
-				commandObject);
+	unsigned int maxRecords = 0;
+	unsigned int chunkRecords = 100;
+	unsigned int prefetch = 1;
+	if (numArgs == 4) {
+		if (!args[1]->IsObject()) {
+			return V8_ERROR("second argument must be an options object");
+		}
+		v8::Local<v8::Object> optionsObject = args[1]->ToObject();
+		const char* rc = GetOption(optionsObject,
+			isnList ? "maxIsns" : "maxRecords", maxRecords);
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "chunkRecords", chunkRecords);
+		}
+		if (rc == NULL) {
+			rc = GetOption(optionsObject, "prefetch", prefetch);
+		}
+		if (rc != NULL) {
+			return V8_ERROR(rc);
 		}
+		if (chunkRecords == 0) {
+			return V8_ERROR("chunkRecords must be greater than 0");
+		}
+	}
+
+	if (!args[numArgs - 2]->IsFunction() ||
+		!args[numArgs - 1]->IsFunction())
+	{
+		return V8_ERROR("last two arguments must be callbacks");
+	}
+	v8::Local<v8::Function> onChunk =
+		v8::Local<v8::Function>::Cast(args[numArgs - 2]);
+	v8::Local<v8::Function> onDone =
+		v8::Local<v8::Function>::Cast(args[numArgs - 1]);
+
+	if (self->m_freeSlots.empty() || !self->m_waitingRequests.empty()) {
+		self->m_busyRejections++;
+		CallBusyCallback(self->handle_, onDone);
+		return scope.Close(v8::False());
+	}
+
+	Reader* reader = new Reader();
+	reader->onChunk = v8::Persistent<v8::Function>::New(onChunk);
+	reader->onDone = v8::Persistent<v8::Function>::New(onDone);
+	reader->command = v8::Persistent<v8::Object>::New(args[0]->ToObject());
+	reader->commandPtr = commandPtr;
+	reader->maxRecords = maxRecords;
+	reader->chunkRecords = chunkRecords;
+	reader->numRecords = 0;
+	reader->finished = false;
+	reader->inFlight = true;
+	reader->paused = false;
+	reader->prefetch = prefetch;
+	reader->aheadChunks = 0;
+	reader->chunkData = NULL;
+	reader->chunkLength = 0;
+	reader->isnList = isnList;
+	reader->isnQuantity = 0;
+	reader->lastIsn = 0;
+
+	self->Ref();
+	if (self->m_pendingCallbacks++ == 0) {
+		uv_ref((uv_handle_t*) self->m_execFinishedMessage);
+	}
+
+	uint32_t slotNo = self->m_freeSlots.back();
+	self->m_freeSlots.pop_back();
+
+	Request& request = self->m_slots[slotNo];
+	request.commandPtr = commandPtr;
+	request.rc = 0;
+	request.sync = false;
+	request.batch = NULL;
+	request.chain = NULL;
+	request.reader = reader;
+	request.session = commandPtr->m_session;
+
+	self->SubmitRequest(slotNo);
+
+	return scope.Close(v8::Boolean::New(self->CheckHighWaterMark()));
+}
+
+/*
+ * Resumes paused reader of the command. Returns false when the command
+ * is not read.
+ */
+v8::Handle<v8::Value>
+Adabas::ResumeRead(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 1) {
+		return V8_ERROR("wrong number of arguments");
 	}
+
+	Command* commandPtr = Command::FromValue(args[0]);
 	if (commandPtr == NULL) {
 		return V8_ERROR(
 			"first argument must be an Adabas control block");
 	}
 
-	v8::Handle<v8::Function> callback;
-        if (numArgs == 2) {
-		if (!args[1]->IsFunction()) {
-			return V8_ERROR("second argument must be a callback");
+	uint32_t slotNo = self->FindReader(commandPtr);
+	if (slotNo == self->m_slots.size()) {
+		return scope.Close(v8::False());
+	}
+
+	Reader* reader = self->m_slots[slotNo].reader;
+	reader->paused = false;
+	if (!reader->inFlight && !self->m_finalized) {
+		reader->inFlight = true;
+		self->SubmitRequest(slotNo);
+	}
+
+	return scope.Close(v8::True());
+}
+
+/*
+ * Reserves buffer of the command: reserve(command, kind, length), where
+ * kind is 'format', 'record', 'search', 'value' or 'isn'. Current buffer
+ * of the command is kept if it is long enough, otherwise the buffer is
+ * taken from the pool of the instance. Sets length of the buffer in the
+ * control block and returns the buffer. Command without owner is adopted
+ * by the instance.
+ */
+v8::Handle<v8::Value>
+Adabas::Reserve(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 3) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	Command* commandPtr = Command::FromValue(args[0]);
+	if (commandPtr == NULL) {
+		return V8_ERROR(
+			"first argument must be an Adabas control block");
+	}
+
+	static const char* kinds[] = {
+		"format", "record", "search", "value", "isn"
+	};
+	std::string kind = *v8::String::Utf8Value(args[1]);
+	unsigned int index = 0;
+	while (index < 5 && kind != kinds[index]) {
+		index++;
+	}
+	if (index == 5) {
+		return V8_ERROR("unknown kind of the buffer");
+	}
+
+	if (!args[2]->IsUint32() || args[2]->Uint32Value() == 0 ||
+		args[2]->Uint32Value() > 0xFFFF)
+	{
+		return V8_ERROR("length must be an integer from 1 to 65535");
+	}
+	uint32_t length = args[2]->Uint32Value();
+
+	v8::Local<v8::Value> buffer = commandPtr->GetBuffer(index);
+	if (buffer->IsNull() ||
+		node::Buffer::Length(buffer->ToObject()) < length)
+	{
+		v8::Local<v8::Object> newBuffer =
+			self->m_bufferPool->NewBuffer(length);
+		if (newBuffer.IsEmpty()) {
+			return ThrowException(node::ErrnoException(ENOMEM, "Reserve"));
 		}
-		callback = v8::Handle<v8::Function>::Cast(args[1]);
-        }
+		commandPtr->SetBuffer(index, newBuffer);
+		buffer = newBuffer;
+	}
+	commandPtr->SetBufferLength(index, (unsigned short) length);
+	if (commandPtr->m_bufferPool == NULL) {
+		commandPtr->SetBufferPool(self->m_bufferPool);
+	}
 
-	if (self->m_requests.size() > 20) {
-#if _DEBUG
-		fprintf(stderr, "[busy]\n");
-#endif // _DEBUG
+	return scope.Close(buffer);
+}
 
-		if (!callback.IsEmpty()) {
-			// Execute the application callback if server is busy.
-			v8::Local<v8::Value> exception =
-				node::ErrnoException(EBUSY, "ExecRequest");
-			v8::Local<v8::Value> callbackArgs[] = { exception };
-			v8::TryCatch try_catch;
-			callback->Call(self->handle_, 1, callbackArgs);
-			if (try_catch.HasCaught()) {
-				node::FatalException(try_catch);
+/*
+ * Makes the instance owner of the command: adopt(command). Buffers
+ * allocated by clone() of the command and of its clones are taken from
+ * the pool of the instance (reserve() adopts the command too).
+ */
+v8::Handle<v8::Value>
+Adabas::Adopt(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 1) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	Command* commandPtr = Command::FromValue(args[0]);
+	if (commandPtr == NULL) {
+		return V8_ERROR("argument must be an Adabas control block");
+	}
+	commandPtr->SetBufferPool(self->m_bufferPool);
+
+	return scope.Close(args[0]);
+}
+
+/*
+ * Returns histograms of request phases (option 'timing'):
+ * timing([reset]). Phases are 'wakeup' (thread wake up), 'queue' (wait
+ * in the queue of the thread), 'dispatch' (session switch), 'call'
+ * (Adabas calls), 'completion' (until the callback), 'total' and
+ * 'commandTime' (command time reported by Adabas, in its units). Values
+ * are in microseconds: count, min, max, mean, p50, p90, p99 and p999.
+ * Histograms are cleared if 'reset' is true.
+ */
+v8::Handle<v8::Value>
+Adabas::Timing(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() > 1) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	v8::Local<v8::Object> timing = v8::Object::New();
+	for (int phase = 0; phase < NUM_PHASES; phase++) {
+		Histogram& histogram = self->m_histograms[phase];
+		double scale = phase == PHASE_COMMAND_TIME ? 1 : 1000;
+
+		v8::Local<v8::Object> stats = v8::Object::New();
+		stats->Set(v8::String::NewSymbol("count"),
+			v8::Number::New(double(histogram.Count())));
+		stats->Set(v8::String::NewSymbol("min"),
+			v8::Number::New(double(histogram.Min()) / scale));
+		stats->Set(v8::String::NewSymbol("max"),
+			v8::Number::New(double(histogram.Max()) / scale));
+		stats->Set(v8::String::NewSymbol("mean"),
+			v8::Number::New(histogram.Mean() / scale));
+		stats->Set(v8::String::NewSymbol("p50"),
+			v8::Number::New(double(histogram.Percentile(50)) / scale));
+		stats->Set(v8::String::NewSymbol("p90"),
+			v8::Number::New(double(histogram.Percentile(90)) / scale));
+		stats->Set(v8::String::NewSymbol("p99"),
+			v8::Number::New(double(histogram.Percentile(99)) / scale));
+		stats->Set(v8::String::NewSymbol("p999"),
+			v8::Number::New(double(histogram.Percentile(99.9)) / scale));
+		timing->Set(v8::String::NewSymbol(phaseNames[phase]), stats);
+
+		if (args.Length() == 1 && args[0]->BooleanValue()) {
+			histogram.Reset();
+		}
+	}
+
+	return scope.Close(timing);
+}
+
+/*
+ * Returns statistics of the thread pool.
+ */
+v8::Handle<v8::Value>
+Adabas::Stats(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 0) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	unsigned int numThreads = 0;
+	unsigned int numBusyThreads = 0;
+	unsigned int numQueuedRequests = 0;
+	for (size_t threadNo = 0; threadNo < self->m_threads.size();
+		threadNo++)
+	{
+		Thread* thread = self->m_threads[threadNo];
+		uint32_t state = AtomicLoad(&thread->state);
+		if (state == THREAD_IDLE || state == THREAD_BUSY) {
+			numThreads++;
+			if (state == THREAD_BUSY) {
+				numBusyThreads++;
 			}
 		}
+		numQueuedRequests += thread->requests.Size();
+	}
 
-		return scope.Close(v8::False());
+	v8::Local<v8::Object> stats = v8::Object::New();
+	stats->Set(v8::String::NewSymbol("threads"),
+		v8::Integer::NewFromUnsigned(numThreads));
+	stats->Set(v8::String::NewSymbol("busyThreads"),
+		v8::Integer::NewFromUnsigned(numBusyThreads));
+	stats->Set(v8::String::NewSymbol("minThreads"),
+		v8::Integer::NewFromUnsigned(self->m_options.minThreads));
+	stats->Set(v8::String::NewSymbol("maxThreads"),
+		v8::Integer::NewFromUnsigned(self->m_options.maxThreads));
+	stats->Set(v8::String::NewSymbol("idleTimeoutMs"),
+		v8::Integer::NewFromUnsigned(self->m_options.idleTimeoutMs));
+	stats->Set(v8::String::NewSymbol("queuedRequests"),
+		v8::Integer::NewFromUnsigned(numQueuedRequests));
+	stats->Set(v8::String::NewSymbol("pendingCallbacks"),
+		v8::Integer::NewFromUnsigned(self->m_pendingCallbacks));
+	stats->Set(v8::String::NewSymbol("freeSlots"),
+		v8::Integer::NewFromUnsigned(self->m_freeSlots.size()));
+	stats->Set(v8::String::NewSymbol("queueDepth"),
+		v8::Integer::NewFromUnsigned(self->m_options.queueDepth));
+	stats->Set(v8::String::NewSymbol("inFlight"),
+		v8::Integer::NewFromUnsigned(self->NumRequestsInFlight()));
+	stats->Set(v8::String::NewSymbol("waitingRequests"),
+		v8::Integer::NewFromUnsigned(self->m_waitingRequests.size()));
+	stats->Set(v8::String::NewSymbol("highWaterMark"),
+		v8::Integer::NewFromUnsigned(self->m_options.highWaterMark));
+	stats->Set(v8::String::NewSymbol("lowWaterMark"),
+		v8::Integer::NewFromUnsigned(self->m_options.lowWaterMark));
+	stats->Set(v8::String::NewSymbol("sessions"),
+		v8::Integer::New(self->NumSessions()));
+
+	const BufferPool::Stats& poolStats = self->m_bufferPool->GetStats();
+	v8::Local<v8::Object> bufferPool = v8::Object::New();
+	bufferPool->Set(v8::String::NewSymbol("hits"),
+		v8::Number::New(double(poolStats.hits)));
+	bufferPool->Set(v8::String::NewSymbol("misses"),
+		v8::Number::New(double(poolStats.misses)));
+	bufferPool->Set(v8::String::NewSymbol("usedBytes"),
+		v8::Number::New(double(poolStats.usedBytes)));
+	bufferPool->Set(v8::String::NewSymbol("freeBytes"),
+		v8::Number::New(double(poolStats.freeBytes)));
+	stats->Set(v8::String::NewSymbol("bufferPool"), bufferPool);
+
+	Metrics::SeriesMap seriesMap;
+	self->CollectMetrics(seriesMap);
+	v8::Local<v8::Array> commands = v8::Array::New(seriesMap.size());
+	uint32_t index = 0;
+	for (Metrics::SeriesMap::const_iterator it = seriesMap.begin();
+		it != seriesMap.end(); ++it)
+	{
+		const Metrics::Series& series = it->second;
+		v8::Local<v8::Object> command = v8::Object::New();
+		command->Set(v8::String::NewSymbol("commandCode"),
+			v8::String::New(series.commandCode, 2));
+		command->Set(v8::String::NewSymbol("dbId"),
+			v8::Integer::NewFromUnsigned(series.dbId));
+		command->Set(v8::String::NewSymbol("fileNo"),
+			v8::Integer::NewFromUnsigned(series.fileNo));
+		command->Set(v8::String::NewSymbol("responseCode"),
+			series.responseCode == Metrics::RESPONSE_CALL_FAILED ?
+				v8::Integer::New(-1) :
+				v8::Integer::NewFromUnsigned(series.responseCode));
+		command->Set(v8::String::NewSymbol("count"),
+			v8::Number::New(double(series.count)));
+		command->Set(v8::String::NewSymbol("totalTime"),
+			v8::Number::New(double(series.totalTime) / 1000));
+		commands->Set(index++, command);
 	}
+	stats->Set(v8::String::NewSymbol("commands"), commands);
 
-	// Append request to the queue.
-	Request request;
-	request.commandPtr = commandPtr;
-	request.callback = v8::Persistent<v8::Function>::New(callback);
+	return scope.Close(stats);
+}
 
-	uv_mutex_lock(&requestsMutex);
-	self->m_requests.push(request);
-	uv_mutex_unlock(&requestsMutex);
+/*
+ * Returns metrics of Adabas calls in Prometheus text format:
+ * prometheus([prefix]), prefix of metric names is 'adabas' by default.
+ */
+v8::Handle<v8::Value>
+Adabas::Prometheus(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
 
-	// Find the available thread.
-	uv_mutex_lock(&threadsMutex);
-	size_t threadNo = 0;
-	size_t numThreads = self->m_threads.size();
-	while (threadNo < numThreads && self->m_threads[threadNo].busy) {
-		threadNo++;
+	if (args.Length() > 1) {
+		return V8_ERROR("wrong number of arguments");
 	}
 
-	if (threadNo == numThreads) {
-		// When all threads is busy, send message to a random thread.
-		threadNo = rand() % numThreads;
+	std::string prefix = "adabas";
+	if (args.Length() == 1) {
+		if (!args[0]->IsString()) {
+			return V8_ERROR("prefix must be a string");
+		}
+		prefix = *v8::String::Utf8Value(args[0]);
 	}
-	Thread& thread = self->m_threads[threadNo];
-	thread.busy = true;
 
-	// Increase reference counters.
-	self->Ref();
-	uv_ref((uv_handle_t*) thread.execMessage);
-	uv_ref((uv_handle_t*) thread.execFinishedMessage);
+	Metrics::SeriesMap seriesMap;
+	self->CollectMetrics(seriesMap);
+	std::string text = Metrics::RenderPrometheus(seriesMap, prefix);
+
+	return scope.Close(v8::String::New(text.data(), int(text.size())));
+}
+
+/*
+ * Adds the sample of gauges to the window and computes busy percents
+ * of threads in the interval since the previous sample (in main thread).
+ */
+void
+Adabas::TakeSample(void)
+{
+	uint64_t now = uv_hrtime();
+	double intervalMs = double(now - m_lastSampleTime) / 1000000;
+	m_lastSampleTime = now;
+
+	Sample& sample = m_samples[m_nextSample];
+	sample.time = uv_now(uv_default_loop());
+	sample.queuedRequests = 0;
+	sample.inFlight = NumRequestsInFlight();
+	sample.waitingRequests = uint32_t(m_waitingRequests.size());
+	sample.threads = 0;
+	sample.busyThreads = 0;
+	sample.wakeUps = 0;
+	sample.steals = 0;
+	sample.busyRejections = m_busyRejections - m_lastBusyRejections;
+	m_lastBusyRejections = m_busyRejections;
+
+	// Counters wrap around, deltas are computed modulo 2^32.
+	double busyTime = 0;
+	for (size_t threadNo = 0; threadNo < m_threads.size(); threadNo++) {
+		Thread* thread = m_threads[threadNo];
+		uint32_t state = AtomicLoad(&thread->state);
+		if (state == THREAD_IDLE || state == THREAD_BUSY) {
+			sample.threads++;
+			if (state == THREAD_BUSY) {
+				sample.busyThreads++;
+			}
+		}
+		sample.queuedRequests += thread->requests.Size();
 
-	// Send message 'exec' to the thread.
-	thread.execMessage->data = (void*) &thread;
-	uv_async_send(thread.execMessage);
-	uv_mutex_unlock(&threadsMutex);
+		uint32_t wakeUps = AtomicLoad(&thread->wakeUps);
+		sample.wakeUps += wakeUps - m_lastWakeUps[threadNo];
+		m_lastWakeUps[threadNo] = wakeUps;
 
-	// Wait sync execution semaphore if callback is not defined.
-	if (callback.IsEmpty()) {
-		uv_mutex_lock(&finishedRequestsMutex);
-		while (self->m_finishedRequests.size() == 0) {
-			uv_cond_wait(&thread.execEndCond, &finishedRequestsMutex);
+		uint32_t steals = AtomicLoad(&thread->steals);
+		sample.steals += steals - m_lastSteals[threadNo];
+		m_lastSteals[threadNo] = steals;
+
+		uint32_t threadBusyTime = AtomicLoad(&thread->busyTime);
+		double delta = double(threadBusyTime - m_lastBusyTime[threadNo]);
+		m_lastBusyTime[threadNo] = threadBusyTime;
+		busyTime += delta;
+
+		double percent = intervalMs > 0 ? delta * 100 / intervalMs : 0;
+		m_busyPercents[threadNo] = percent > 100 ? 100 : percent;
+	}
+
+	sample.busyPercent = 0;
+	if (sample.threads > 0 && intervalMs > 0) {
+		sample.busyPercent = busyTime * 100 / (intervalMs * sample.threads);
+		if (sample.busyPercent > 100) {
+			sample.busyPercent = 100;
 		}
+	}
 
-		Request finishedRequest = self->m_finishedRequests.back();
-		self->m_finishedRequests.pop_back();
-		uv_mutex_unlock(&finishedRequestsMutex);
+	m_nextSample = (m_nextSample + 1) % m_samples.size();
+	if (m_numSamples < m_samples.size()) {
+		m_numSamples++;
+	}
+}
 
-		// Return result code.
-		return scope.Close(
-			v8::Number::New(int32_t(finishedRequest.rc)));
+/*
+ * Converts the sample of gauges to JS object.
+ */
+v8::Local<v8::Object>
+Adabas::SampleToObject(const Sample& sample)
+{
+	v8::Local<v8::Object> object = v8::Object::New();
+	object->Set(v8::String::NewSymbol("time"),
+		v8::Number::New(double(sample.time)));
+	object->Set(v8::String::NewSymbol("queuedRequests"),
+		v8::Integer::NewFromUnsigned(sample.queuedRequests));
+	object->Set(v8::String::NewSymbol("inFlight"),
+		v8::Integer::NewFromUnsigned(sample.inFlight));
+	object->Set(v8::String::NewSymbol("waitingRequests"),
+		v8::Integer::NewFromUnsigned(sample.waitingRequests));
+	object->Set(v8::String::NewSymbol("threads"),
+		v8::Integer::NewFromUnsigned(sample.threads));
+	object->Set(v8::String::NewSymbol("busyThreads"),
+		v8::Integer::NewFromUnsigned(sample.busyThreads));
+	object->Set(v8::String::NewSymbol("busyPercent"),
+		v8::Number::New(sample.busyPercent));
+	object->Set(v8::String::NewSymbol("wakeUps"),
+		v8::Integer::NewFromUnsigned(sample.wakeUps));
+	object->Set(v8::String::NewSymbol("steals"),
+		v8::Integer::NewFromUnsigned(sample.steals));
+	object->Set(v8::String::NewSymbol("busyRejections"),
+		v8::Integer::NewFromUnsigned(sample.busyRejections));
+	return object;
+}
+
+/*
+ * Returns gauges of the pool: current queue depth, requests in flight
+ * and waiting requests, totals of thread wake ups, steals and EBUSY
+ * rejections, array 'perThread' of '{ state, wakeUps, steals, busyTime,
+ * busyPercent }' (busy percent in the last sampling interval) and array
+ * 'samples' of the sampling window, oldest sample first (option
+ * 'sampleIntervalMs').
+ */
+v8::Handle<v8::Value>
+Adabas::Gauges(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 0) {
+		return V8_ERROR("wrong number of arguments");
 	}
 
-	return scope.Close(v8::True());
+	static const char* stateNames[] = {
+		"stopped", "idle", "busy", "exiting"
+	};
+
+	uint32_t numQueuedRequests = 0;
+	uint32_t wakeUps = 0;
+	uint32_t steals = 0;
+	v8::Local<v8::Array> perThread = v8::Array::New(self->m_threads.size());
+	for (size_t threadNo = 0; threadNo < self->m_threads.size();
+		threadNo++)
+	{
+		Thread* thread = self->m_threads[threadNo];
+		numQueuedRequests += thread->requests.Size();
+
+		v8::Local<v8::Object> threadGauges = v8::Object::New();
+		threadGauges->Set(v8::String::NewSymbol("state"),
+			v8::String::NewSymbol(
+				stateNames[AtomicLoad(&thread->state)]));
+		uint32_t threadWakeUps = AtomicLoad(&thread->wakeUps);
+		threadGauges->Set(v8::String::NewSymbol("wakeUps"),
+			v8::Integer::NewFromUnsigned(threadWakeUps));
+		uint32_t threadSteals = AtomicLoad(&thread->steals);
+		threadGauges->Set(v8::String::NewSymbol("steals"),
+			v8::Integer::NewFromUnsigned(threadSteals));
+		threadGauges->Set(v8::String::NewSymbol("busyTime"),
+			v8::Integer::NewFromUnsigned(AtomicLoad(&thread->busyTime)));
+		threadGauges->Set(v8::String::NewSymbol("busyPercent"),
+			v8::Number::New(self->m_busyPercents[threadNo]));
+		perThread->Set(uint32_t(threadNo), threadGauges);
+
+		wakeUps += threadWakeUps;
+		steals += threadSteals;
+	}
+
+	v8::Local<v8::Object> gauges = v8::Object::New();
+	gauges->Set(v8::String::NewSymbol("queuedRequests"),
+		v8::Integer::NewFromUnsigned(numQueuedRequests));
+	gauges->Set(v8::String::NewSymbol("inFlight"),
+		v8::Integer::NewFromUnsigned(self->NumRequestsInFlight()));
+	gauges->Set(v8::String::NewSymbol("waitingRequests"),
+		v8::Integer::NewFromUnsigned(self->m_waitingRequests.size()));
+	gauges->Set(v8::String::NewSymbol("wakeUps"),
+		v8::Integer::NewFromUnsigned(wakeUps));
+	gauges->Set(v8::String::NewSymbol("steals"),
+		v8::Integer::NewFromUnsigned(steals));
+	gauges->Set(v8::String::NewSymbol("busyRejections"),
+		v8::Integer::NewFromUnsigned(self->m_busyRejections));
+	gauges->Set(v8::String::NewSymbol("perThread"), perThread);
+
+	size_t numSamples = self->m_numSamples;
+	v8::Local<v8::Array> samples = v8::Array::New(numSamples);
+	for (size_t i = 0; i < numSamples; i++) {
+		size_t index = (self->m_nextSample + self->m_samples.size() -
+			numSamples + i) % self->m_samples.size();
+		samples->Set(uint32_t(i), SampleToObject(self->m_samples[index]));
+	}
+	gauges->Set(v8::String::NewSymbol("samples"), samples);
+
+	return scope.Close(gauges);
+}
+
+/*
+ * Converts the call of the flight recorder to JS object: control block
+ * fields, thread number (-1 - main thread), start time (milliseconds,
+ * process.hrtime() clock), duration (microseconds) and result code.
+ */
+v8::Local<v8::Object>
+Adabas::CallToObject(const FlightRecorder::Call& call)
+{
+	const CB_PAR& cb = call.cb;
+	bool physical = CB_PHYS_FILE_NR(&cb);
+
+	v8::Local<v8::Object> object = v8::Object::New();
+	object->Set(v8::String::NewSymbol("thread"),
+		v8::Integer::New(call.threadNo));
+	object->Set(v8::String::NewSymbol("time"),
+		v8::Number::New(double(call.time) / 1000000));
+	object->Set(v8::String::NewSymbol("duration"),
+		v8::Number::New(double(call.duration) / 1000));
+	object->Set(v8::String::NewSymbol("rc"),
+		v8::Integer::New(call.rc));
+	object->Set(v8::String::NewSymbol("commandCode"),
+		transcode::NewString(transcode::LATIN1,
+			reinterpret_cast<const unsigned char*>(cb.cb_cmd_code),
+			sizeof(cb.cb_cmd_code)));
+	object->Set(v8::String::NewSymbol("commandId"),
+		transcode::NewString(transcode::LATIN1,
+			reinterpret_cast<const unsigned char*>(cb.cb_cmd_id),
+			sizeof(cb.cb_cmd_id)));
+	object->Set(v8::String::NewSymbol("dbId"), v8::Integer::NewFromUnsigned(
+		physical ? cb.alt_cb_db_id : cb.cb_db_id));
+	object->Set(v8::String::NewSymbol("fileNo"), v8::Integer::NewFromUnsigned(
+		physical ? cb.alt_cb_file_nr : cb.cb_file_nr));
+	object->Set(v8::String::NewSymbol("returnCode"),
+		v8::Integer::NewFromUnsigned(cb.cb_return_code));
+	object->Set(v8::String::NewSymbol("isn"),
+		v8::Integer::NewFromUnsigned(cb.cb_isn));
+	object->Set(v8::String::NewSymbol("isnLowerLimit"),
+		v8::Integer::NewFromUnsigned(cb.cb_isn_ll));
+	object->Set(v8::String::NewSymbol("isnQuantity"),
+		v8::Integer::NewFromUnsigned(cb.cb_isn_quantity));
+	object->Set(v8::String::NewSymbol("formatBufferLength"),
+		v8::Integer::NewFromUnsigned(cb.cb_fmt_buf_lng));
+	object->Set(v8::String::NewSymbol("recordBufferLength"),
+		v8::Integer::NewFromUnsigned(cb.cb_rec_buf_lng));
+	object->Set(v8::String::NewSymbol("searchBufferLength"),
+		v8::Integer::NewFromUnsigned(cb.cb_sea_buf_lng));
+	object->Set(v8::String::NewSymbol("valueBufferLength"),
+		v8::Integer::NewFromUnsigned(cb.cb_val_buf_lng));
+	object->Set(v8::String::NewSymbol("isnBufferLength"),
+		v8::Integer::NewFromUnsigned(cb.cb_isn_buf_lng));
+	object->Set(v8::String::NewSymbol("commandOption1"),
+		v8::Integer::NewFromUnsigned(
+			reinterpret_cast<const unsigned char&>(cb.cb_cop1)));
+	object->Set(v8::String::NewSymbol("commandOption2"),
+		v8::Integer::NewFromUnsigned(
+			reinterpret_cast<const unsigned char&>(cb.cb_cop2)));
+	object->Set(v8::String::NewSymbol("commandTime"),
+		v8::Integer::NewFromUnsigned(cb.cb_cmd_time));
+	return object;
+}
+
+/*
+ * Returns calls of flight recorders of all threads (option
+ * 'flightRecorder') sorted by start time.
+ */
+v8::Handle<v8::Value>
+Adabas::FlightRecorderCalls(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 0) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	std::vector<FlightRecorder::Call> calls;
+	std::vector<FlightRecorder::SlowCall> slowCalls;
+	self->CollectCalls(calls, slowCalls);
+
+	v8::Local<v8::Array> array = v8::Array::New(calls.size());
+	for (size_t i = 0; i < calls.size(); i++) {
+		array->Set(uint32_t(i), CallToObject(calls[i]));
+	}
+	return scope.Close(array);
+}
+
+/*
+ * Returns slow calls of all threads (option 'slowCommandMs') sorted by
+ * start time. Calls have the first bytes of their buffers: formatBuffer,
+ * recordBuffer, searchBuffer, valueBuffer and isnBuffer (record buffer
+ * and ISN buffer are copied after the call).
+ */
+v8::Handle<v8::Value>
+Adabas::SlowLog(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 0) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	static const char* bufferNames[FlightRecorder::NUM_BUFFERS] = {
+		"formatBuffer", "recordBuffer", "searchBuffer", "valueBuffer",
+		"isnBuffer"
+	};
+
+	std::vector<FlightRecorder::Call> calls;
+	std::vector<FlightRecorder::SlowCall> slowCalls;
+	self->CollectCalls(calls, slowCalls);
+
+	v8::Local<v8::Array> array = v8::Array::New(slowCalls.size());
+	for (size_t i = 0; i < slowCalls.size(); i++) {
+		const FlightRecorder::SlowCall& slowCall = slowCalls[i];
+		v8::Local<v8::Object> object = CallToObject(slowCall.call);
+		for (unsigned int buffer = 0; buffer < FlightRecorder::NUM_BUFFERS;
+			buffer++)
+		{
+			const std::string& data = slowCall.buffers[buffer];
+			node::Buffer* copy = node::Buffer::New(data.data(), data.size());
+			object->Set(v8::String::NewSymbol(bufferNames[buffer]),
+				v8::Local<v8::Object>::New(copy->handle_));
+		}
+		array->Set(uint32_t(i), object);
+	}
+	return scope.Close(array);
+}
+
+/*
+ * Returns text of flight recorders and slow logs of all threads, which
+ * is written to stderr on signal SIGUSR2 with option 'dumpOnSignal'.
+ */
+v8::Handle<v8::Value>
+Adabas::DumpFlightRecorder(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 0) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	std::string text = self->DumpFlightRecorders();
+	return scope.Close(v8::String::New(text.data(), int(text.size())));
+}
+
+/*
+ * Returns array of sessions '{ session, thread, rc }', where 'rc' is
+ * result code of the session command 'OP' (undefined until it finishes).
+ */
+v8::Handle<v8::Value>
+Adabas::Sessions(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Adabas* self = ObjectWrap::Unwrap<Adabas>(args.This());
+
+	if (args.Length() != 0) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	v8::Local<v8::Array> sessions = v8::Array::New(self->NumSessions());
+	uint32_t sessionHandle = 0;
+	for (size_t threadNo = 0; threadNo < self->m_threads.size();
+		threadNo++)
+	{
+		Thread* thread = self->m_threads[threadNo];
+		for (size_t sessionNo = 0; sessionNo < thread->sessions.size();
+			sessionNo++)
+		{
+			Session& session = thread->sessions[sessionNo];
+			v8::Local<v8::Object> sessionObject = v8::Object::New();
+			sessionObject->Set(v8::String::NewSymbol("session"),
+				v8::Integer::NewFromUnsigned(sessionHandle));
+			sessionObject->Set(v8::String::NewSymbol("thread"),
+				v8::Integer::NewFromUnsigned(threadNo));
+			if (AtomicLoad(&session.opened)) {
+				sessionObject->Set(rcSymbol,
+					v8::Number::New(int32_t(session.rc)));
+			}
+			sessions->Set(sessionHandle++, sessionObject);
+		}
+	}
+
+	return scope.Close(sessions);
 }
 
 } // namespace node_adabas
@@ -3,10 +3,15 @@
 
 #include <deque>
 #include <node.h>
-#include <queue>
+#include <string>
 #include <vector>
 
+#include "buffer_pool.h"
 #include "command.h"
+#include "flight_recorder.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "ring_buffer.h"
 
 namespace node_adabas {
 
@@ -15,17 +20,259 @@ namespace node_adabas {
  */
 class Adabas : public node::ObjectWrap {
 public:
+	/*
+	 * Options of the thread pool ('new Adabas({ ... })').
+	 */
+	struct Options {
+		// Number of threads kept alive when the pool is idle.
+		unsigned int minThreads;
+		// Maximal number of threads in the pool.
+		unsigned int maxThreads;
+		// Idle time after which a thread above minimum exits (0 - never).
+		unsigned int idleTimeoutMs;
+		// Number of Adabas sessions opened by each thread (0 - none).
+		unsigned int sessionsPerThread;
+		// Database ID and record buffer of the session command 'OP'.
+		unsigned int sessionDbId;
+		std::string sessionRecordBuffer;
+		// Number of request slots (maximal number of requests in flight).
+		unsigned int queueDepth;
+		// exec() returns false when number of requests in flight reaches
+		// high watermark, event 'drain' is emitted when it falls to low
+		// watermark.
+		unsigned int highWaterMark;
+		unsigned int lowWaterMark;
+		// Number of asynchronous requests waiting for the free slot
+		// (they are rejected with EBUSY when the wait queue is full).
+		unsigned int waitQueue;
+		// Flag is true when requests are timed (see timing()).
+		bool timing;
+		// Interval of sampling of gauges (0 - no sampling) and number of
+		// samples kept in the window (see gauges()).
+		unsigned int sampleIntervalMs;
+		unsigned int sampleWindow;
+		// Number of calls kept by the flight recorder of each thread
+		// (0 - none).
+		unsigned int flightRecorder;
+		// Calls longer than threshold (milliseconds, may be fractional,
+		// 0 - none) are copied to the slow log of the thread with the
+		// first bytes of each buffer.
+		double slowCommandMs;
+		unsigned int slowLogSize;
+		unsigned int slowCommandBytes;
+		// Flag is true when SIGUSR2 dumps flight recorders to stderr.
+		bool dumpOnSignal;
+
+		Options();
+	};
+
+	/*
+	 * Requests submitted by execMany() with the single callback.
+	 */
+	struct Batch {
+		v8::Persistent<v8::Function> callback;
+		// Array of commands (keeps commands alive while executing).
+		v8::Persistent<v8::Object> commands;
+		uint32_t numRequests;
+		// Indexes and result codes of finished commands.
+		std::vector<uint32_t> indexes;
+		std::vector<int> rcs;
+	};
+
+	/*
+	 * Chain of commands executed one after another by the single request.
+	 */
+	struct Chain {
+		v8::Persistent<v8::Function> callback;
+		// Array of commands (keeps commands alive while executing).
+		v8::Persistent<v8::Object> commands;
+		std::vector<Command*> commandPtrs;
+		// Flag is true when chain stops at the first failed command.
+		bool stopOnRc;
+		// Result codes of executed commands.
+		std::vector<int> rcs;
+	};
+
+	/*
+	 * Sequential reader (readAll() and readIsns()), which reads the chunk
+	 * of records or the page of ISNs by the single request.
+	 */
+	struct Reader {
+		v8::Persistent<v8::Function> onChunk;
+		v8::Persistent<v8::Function> onDone;
+		// Command (keeps command alive while reading).
+		v8::Persistent<v8::Object> command;
+		Command* commandPtr;
+		// Maximal number of records (0 - unlimited) and records per chunk.
+		uint32_t maxRecords;
+		uint32_t chunkRecords;
+		// Number of records read.
+		uint32_t numRecords;
+		// Flag is true when reading is finished (EOF, error or limit).
+		bool finished;
+		// Flag is true when the request for the next chunk is submitted.
+		bool inFlight;
+		// Paused reader (onChunk() returned false) reads ahead only
+		// 'prefetch' chunks until resumeRead() is called.
+		bool paused;
+		uint32_t prefetch;
+		uint32_t aheadChunks;
+		// Chunk of records and their ISNs filled by the thread.
+		char* chunkData;
+		size_t chunkLength;
+		std::vector<uint32_t> chunkIsns;
+		// Reader of ISN list (readIsns()): chunk contains ISNs only, ISN
+		// quantity of the search and the last ISN read.
+		bool isnList;
+		uint32_t isnQuantity;
+		uint32_t lastIsn;
+	};
+
+	// Timestamps of the request (uv_hrtime(), recorded with option
+	// 'timing').
+	enum {
+		TIME_SUBMITTED,
+		TIME_DEQUEUED,
+		TIME_CALL_STARTED,
+		TIME_CALL_FINISHED,
+		TIME_COMPLETED,
+		TIME_CALLBACK,
+		NUM_TIMES
+	};
+
+	// Phases of the request measured by histograms.
+	enum {
+		PHASE_WAKEUP,
+		PHASE_QUEUE,
+		PHASE_DISPATCH,
+		PHASE_CALL,
+		PHASE_COMPLETION,
+		PHASE_TOTAL,
+		PHASE_COMMAND_TIME,
+		NUM_PHASES
+	};
+
+	/*
+	 * Request slot. Slots are preallocated, queues pass slot numbers.
+	 */
 	struct Request {
 		Command* commandPtr;
+		// Command of the asynchronous request (keeps command and its
+		// buffers alive while executing).
+		v8::Persistent<v8::Object> command;
 		int rc;
+		// Flag is true when main thread waits for the request.
+		bool sync;
 		v8::Persistent<v8::Function> callback;
+		// Batch of the request and index of the command in the batch.
+		Batch* batch;
+		uint32_t index;
+		// Chain of commands executed instead of the single command.
+		Chain* chain;
+		// Reader, which reads the chunk of records by the request.
+		Reader* reader;
+		// Session of the request (-1 - any thread, no session).
+		int session;
+		// Timestamps of the request and wake up time of the thread,
+		// which executed it.
+		uint64_t times[NUM_TIMES];
+		uint64_t wakeUpTime;
+	};
+
+	/*
+	 * Sample of gauges of the pool. Counters are deltas over the sampling
+	 * interval.
+	 */
+	struct Sample {
+		// Time of the sample (milliseconds, uv_now()).
+		uint64_t time;
+		uint32_t queuedRequests;
+		uint32_t inFlight;
+		uint32_t waitingRequests;
+		uint32_t threads;
+		uint32_t busyThreads;
+		// Busy time of running threads in percents of the interval.
+		double busyPercent;
+		uint32_t wakeUps;
+		uint32_t steals;
+		uint32_t busyRejections;
 	};
 
+	/*
+	 * Asynchronous request waiting for the free request slot.
+	 */
+	struct WaitingRequest {
+		Command* commandPtr;
+		v8::Persistent<v8::Object> command;
+		v8::Persistent<v8::Function> callback;
+	};
+
+	/*
+	 * Metrics and flight recorder of Adabas calls of one thread.
+	 */
+	struct CallLog {
+		Metrics::Shard metrics;
+		FlightRecorder flightRecorder;
+	};
+
+	/*
+	 * Adabas session owned by the thread.
+	 */
+	struct Session {
+		// Adabas ID (lnk_set_adabas_id()) of the session.
+		unsigned char adabasId[8];
+		// Result code of the session command 'OP'.
+		int rc;
+		// Flag is set when command 'OP' is finished.
+		volatile uint32_t opened;
+	};
+
+	// States of the thread.
+	enum {
+		THREAD_STOPPED,
+		THREAD_IDLE,
+		THREAD_BUSY,
+		THREAD_EXITING
+	};
+
+	/*
+	 * Entry of the thread table. Entries live as long as the Adabas
+	 * instance, so other threads may steal requests from its queue
+	 * while the thread is started and stopped.
+	 */
 	struct Thread {
 		Adabas* self;
+		// Number of the entry in the thread table.
+		uint32_t threadNo;
+
+		// State of the thread (THREAD_STOPPED, THREAD_IDLE, ...).
+		volatile uint32_t state;
+		// Flag is set when thread event loop is finished.
+		volatile uint32_t exited;
 
-		// Flag is true when request already running.
-		bool busy;
+		// Submitted requests (main thread to pool threads).
+		MpmcRing<uint32_t> requests;
+		// Requests of the thread sessions (they are never stolen).
+		SpscRing<uint32_t> sessionRequests;
+		// Finished asynchronous requests (thread to main thread).
+		SpscRing<uint32_t> finishedRequests;
+
+		// Sessions of the thread and session of the last direct call
+		// (-1 - default Adabas ID of the thread).
+		std::vector<Session> sessions;
+		int currentSession;
+		unsigned char adabasId[8];
+		// Time when the thread was woken up by the message.
+		uint64_t wakeUpTime;
+		// Metrics and flight recorder of Adabas calls of the thread.
+		CallLog callLog;
+		// Counters of the thread (written by the thread only): wake ups
+		// by the message, requests stolen from other threads and time
+		// spent executing requests (milliseconds, wraps around).
+		volatile uint32_t wakeUps;
+		volatile uint32_t steals;
+		volatile uint32_t busyTime;
+		uint64_t busyTimeNs;
 
 		/* The thread internal variables. */
 		uv_thread_t threadId;
@@ -33,29 +280,152 @@ public:
 		uv_sem_t threadExitSemaphore;
 		uv_async_t* exitMessage;
 		uv_async_t* execMessage;
-		uv_async_t* execFinishedMessage;
-		uv_cond_t execEndCond;
+		uv_timer_t* idleTimer;
 	};
 
 private:
 	static v8::Persistent<v8::Function> constructor;
 
-	std::vector<Thread> m_threads;
-	std::queue<Request> m_requests;
-	std::deque<Request> m_finishedRequests;
+	Options m_options;
+	bool m_finalized;
+
+	// Thread table with 'maxThreads' entries.
+	std::vector<Thread*> m_threads;
+	// Number of threads which are not leaving the pool.
+	volatile uint32_t m_numThreads;
+
+	// Request slots and the list of free slots (main thread only).
+	std::vector<Request> m_slots;
+	std::vector<uint32_t> m_freeSlots;
+	// Requests waiting for the free slot (main thread only).
+	std::deque<WaitingRequest> m_waitingRequests;
+	// Flag is set when high watermark was reached and 'drain' is expected.
+	bool m_needDrain;
+
+	// Number of asynchronous requests waiting for the callback.
+	unsigned int m_pendingCallbacks;
+	// Batches which are finished, but callbacks are not called yet.
+	std::vector<Batch*> m_finishedBatches;
+
+	// Pool of buffers reserved for commands (reserve()).
+	BufferPool* m_bufferPool;
+
+	// Histograms of request phases (option 'timing', main thread only).
+	Histogram m_histograms[NUM_PHASES];
+	// Metrics and flight recorder of Adabas calls executed in main
+	// thread (execSync()).
+	CallLog m_callLog;
+	// Handle of signal, which dumps flight recorders.
+	uv_signal_t* m_dumpSignal;
+
+	// Number of requests rejected with EBUSY (main thread only).
+	uint32_t m_busyRejections;
+	// Sampling timer and the window of samples (ring, main thread only).
+	uv_timer_t* m_sampleTimer;
+	std::vector<Sample> m_samples;
+	size_t m_numSamples;
+	size_t m_nextSample;
+	// Counters at the previous sample and busy percents of threads in
+	// the last sampling interval.
+	uint64_t m_lastSampleTime;
+	uint32_t m_lastBusyRejections;
+	std::vector<uint32_t> m_lastWakeUps;
+	std::vector<uint32_t> m_lastSteals;
+	std::vector<uint32_t> m_lastBusyTime;
+	std::vector<double> m_busyPercents;
+
+	/* Main thread messages and synchronous execution semaphore. */
+	uv_async_t* m_execFinishedMessage;
+	uv_async_t* m_threadExitedMessage;
+	uv_sem_t m_execEndSemaphore;
 
 private:
-	Adabas();
+	Adabas(const Options& options);
 	~Adabas();
 
+	void StartThread(Thread* thread);
+	void StopThread(Thread* thread);
+	Thread* SelectThread(bool& wakeUp);
+	void SubmitRequest(uint32_t slotNo);
+	uint32_t PrepareRequest(Command* commandPtr,
+		v8::Handle<v8::Function> callback);
+	void SubmitWaitingRequests(void);
+	bool CheckHighWaterMark(void);
+	void CheckLowWaterMark(void);
+	bool PopRequest(Thread& thread, uint32_t& slotNo);
+	bool HasRequests(Thread& thread);
+	uint32_t NumRequestsInFlight(void) const
+	{
+		return m_options.queueDepth - m_freeSlots.size();
+	}
+	int NumSessions(void) const
+	{
+		return int(m_options.sessionsPerThread * m_threads.size());
+	}
+	// Threshold of slow calls in nanoseconds (0 - none).
+	uint64_t SlowThreshold(void) const
+	{
+		uint64_t threshold = uint64_t(m_options.slowCommandMs * 1000000);
+		return threshold == 0 && m_options.slowCommandMs > 0 ?
+			1 : threshold;
+	}
+	void ExecuteRequest(Thread& thread, uint32_t slotNo);
+	void WakeUpThread(Thread* thread, bool wakeUp);
+	void OpenSessions(Thread& thread);
+	void CloseSessions(Thread& thread);
+	static void SelectSession(Thread& thread, int session);
+	void ProcessFinishedRequests(Thread* thread);
+	void ProcessFinishedBatches(void);
+	void ProcessFinishedChain(Chain* chain);
+	void ProcessReaderChunk(uint32_t slotNo);
+	void CancelRequests(void);
+	void FinishRequests(void);
+	void CloseExecFinishedMessage(void);
+	static int ReadChunk(Reader& reader, CallLog& callLog);
+	static int ReadIsnChunk(Reader& reader, CallLog& callLog);
+	v8::Handle<v8::Value> StartReader(const v8::Arguments& args,
+		bool isnList);
+	uint32_t FindReader(Command* commandPtr);
+	v8::Local<v8::Value> RecordTiming(Request& request);
+	void CollectMetrics(Metrics::SeriesMap& series) const;
+	void CollectCalls(std::vector<FlightRecorder::Call>& calls,
+		std::vector<FlightRecorder::SlowCall>& slowCalls) const;
+	std::string DumpFlightRecorders(void) const;
+	static v8::Local<v8::Object> CallToObject(
+		const FlightRecorder::Call& call);
+	void TakeSample(void);
+	static v8::Local<v8::Object> SampleToObject(const Sample& sample);
+
 	static void ThreadEventLoop(void* data);
 	static void ThreadOnExit(uv_async_t* handle, int status);
 	static void ThreadOnExec(uv_async_t* handle, int status);
+	static void ThreadOnIdle(uv_timer_t* handle, int status);
 	static void OnExecFinished(uv_async_t* handle, int status);
+	static void OnThreadExited(uv_async_t* handle, int status);
+	static void OnSample(uv_timer_t* handle, int status);
+	static void OnDumpSignal(uv_signal_t* handle, int signum);
 
 	static v8::Handle<v8::Value> New(const v8::Arguments& args);
 	static v8::Handle<v8::Value> Close(const v8::Arguments& args);
 	static v8::Handle<v8::Value> Exec(const v8::Arguments& args);
+	static v8::Handle<v8::Value> ExecSync(const v8::Arguments& args);
+	static v8::Handle<v8::Value> ExecMany(const v8::Arguments& args);
+	static v8::Handle<v8::Value> ExecChain(const v8::Arguments& args);
+	static v8::Handle<v8::Value> ReadAll(const v8::Arguments& args);
+	static v8::Handle<v8::Value> ReadIsns(const v8::Arguments& args);
+	static v8::Handle<v8::Value> ResumeRead(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Reserve(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Adopt(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Timing(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Stats(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Prometheus(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Gauges(const v8::Arguments& args);
+	static v8::Handle<v8::Value> FlightRecorderCalls(
+		const v8::Arguments& args);
+	static v8::Handle<v8::Value> SlowLog(const v8::Arguments& args);
+	static v8::Handle<v8::Value> DumpFlightRecorder(
+		const v8::Arguments& args);
+	static v8::Handle<v8::Value> Sessions(const v8::Arguments& args);
 
 public:
 	static void Initialize(v8::Handle<v8::Object> exports);
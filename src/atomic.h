@@ -0,0 +1,113 @@
+#ifndef NODE_ADABAS_SRC_ATOMIC_H
+#define NODE_ADABAS_SRC_ATOMIC_H
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+
+#include <uv.h>
+
+namespace node_adabas {
+
+/*
+ * Minimal set of atomic operations on 32-bit words (C++0x <atomic> is not
+ * available in all supported compilers). Loads have acquire semantics,
+ * stores have release semantics, read-modify-write operations and
+ * AtomicFence() are full memory barriers.
+ */
+#ifdef _MSC_VER
+
+inline void
+AtomicFence(void)
+{
+	_mm_mfence();
+}
+
+inline uint32_t
+AtomicLoad(const volatile uint32_t* value)
+{
+	uint32_t result = *value;
+	_ReadWriteBarrier();
+	return result;
+}
+
+inline void
+AtomicStore(volatile uint32_t* value, uint32_t newValue)
+{
+	_ReadWriteBarrier();
+	*value = newValue;
+}
+
+inline bool
+AtomicCompareExchange(volatile uint32_t* value, uint32_t expected,
+	uint32_t newValue)
+{
+	return (uint32_t) _InterlockedCompareExchange((volatile long*) value,
+		(long) newValue, (long) expected) == expected;
+}
+
+inline uint32_t
+AtomicExchange(volatile uint32_t* value, uint32_t newValue)
+{
+	return (uint32_t) _InterlockedExchange((volatile long*) value,
+		(long) newValue);
+}
+
+inline uint32_t
+AtomicAdd(volatile uint32_t* value, uint32_t delta)
+{
+	return (uint32_t) _InterlockedExchangeAdd((volatile long*) value,
+		(long) delta) + delta;
+}
+
+#else
+
+inline void
+AtomicFence(void)
+{
+	__sync_synchronize();
+}
+
+inline uint32_t
+AtomicLoad(const volatile uint32_t* value)
+{
+	uint32_t result = *value;
+	__sync_synchronize();
+	return result;
+}
+
+inline void
+AtomicStore(volatile uint32_t* value, uint32_t newValue)
+{
+	__sync_synchronize();
+	*value = newValue;
+}
+
+inline bool
+AtomicCompareExchange(volatile uint32_t* value, uint32_t expected,
+	uint32_t newValue)
+{
+	return __sync_bool_compare_and_swap(value, expected, newValue);
+}
+
+inline uint32_t
+AtomicExchange(volatile uint32_t* value, uint32_t newValue)
+{
+	uint32_t oldValue;
+	do {
+		oldValue = *value;
+	} while (!__sync_bool_compare_and_swap(value, oldValue, newValue));
+	return oldValue;
+}
+
+inline uint32_t
+AtomicAdd(volatile uint32_t* value, uint32_t delta)
+{
+	return __sync_add_and_fetch(value, delta);
+}
+
+#endif // _MSC_VER
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_ATOMIC_H
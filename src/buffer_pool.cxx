@@ -0,0 +1,150 @@
+#include <cstdlib>
+#include <node_buffer.h>
+
+#include "buffer_pool.h"
+
+// Header of the block before Buffer data (keeps data aligned).
+#define BLOCK_HEADER_SIZE 16
+
+namespace node_adabas {
+
+/*
+ * Header of the block.
+ */
+struct BlockHeader {
+	BufferPool* pool;
+	// Size of the block (blocks larger than MAX_BLOCK_SIZE aren't pooled).
+	size_t size;
+};
+
+/*
+ * Constructor.
+ */
+BufferPool::BufferPool() :
+	m_numUsedBlocks(0),
+	m_refs(1)
+{
+	unsigned int numClasses = 0;
+	while (BlockSize(numClasses) < MAX_BLOCK_SIZE) {
+		numClasses++;
+	}
+	m_freeBlocks.resize(numClasses + 1);
+
+	m_stats.hits = 0;
+	m_stats.misses = 0;
+	m_stats.usedBytes = 0;
+	m_stats.freeBytes = 0;
+}
+
+/*
+ * Destructor.
+ */
+BufferPool::~BufferPool()
+{
+	for (size_t i = 0; i < m_freeBlocks.size(); i++) {
+		for (size_t j = 0; j < m_freeBlocks[i].size(); j++) {
+			free(m_freeBlocks[i][j]);
+		}
+	}
+}
+
+/*
+ * Returns size of blocks of the size class.
+ */
+size_t
+BufferPool::BlockSize(unsigned int sizeClass)
+{
+	return MIN_BLOCK_SIZE << sizeClass;
+}
+
+/*
+ * Returns the smallest size class of blocks, which hold 'length' bytes
+ * (number of size classes - length is too large for the pool).
+ */
+unsigned int
+BufferPool::SizeClass(size_t length) const
+{
+	unsigned int sizeClass = 0;
+	while (sizeClass < m_freeBlocks.size() && BlockSize(sizeClass) < length)
+	{
+		sizeClass++;
+	}
+	return sizeClass;
+}
+
+v8::Local<v8::Object>
+BufferPool::NewBuffer(size_t length)
+{
+	unsigned int sizeClass = SizeClass(length);
+	size_t blockSize = sizeClass < m_freeBlocks.size() ?
+		BlockSize(sizeClass) : length;
+
+	char* block = NULL;
+	if (sizeClass < m_freeBlocks.size() &&
+		!m_freeBlocks[sizeClass].empty())
+	{
+		block = m_freeBlocks[sizeClass].back();
+		m_freeBlocks[sizeClass].pop_back();
+		m_stats.freeBytes -= blockSize;
+		m_stats.hits++;
+	} else {
+		block = static_cast<char*>(malloc(BLOCK_HEADER_SIZE + blockSize));
+		if (block == NULL) {
+			return v8::Local<v8::Object>();
+		}
+		BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+		header->pool = this;
+		header->size = blockSize;
+		m_stats.misses++;
+	}
+	m_stats.usedBytes += blockSize;
+	m_numUsedBlocks++;
+
+	node::Buffer* buffer = node::Buffer::New(block + BLOCK_HEADER_SIZE,
+		length, FreeBlock, NULL);
+	return v8::Local<v8::Object>::New(buffer->handle_);
+}
+
+/*
+ * Returns the block of collected Buffer to the pool.
+ */
+void
+BufferPool::FreeBlock(char* data, void* hint)
+{
+	char* block = data - BLOCK_HEADER_SIZE;
+	BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+	BufferPool* pool = header->pool;
+	size_t blockSize = header->size;
+	pool->m_numUsedBlocks--;
+	pool->m_stats.usedBytes -= blockSize;
+
+	unsigned int sizeClass = pool->SizeClass(blockSize);
+	if (pool->m_refs > 0 && sizeClass < pool->m_freeBlocks.size() &&
+		pool->m_freeBlocks[sizeClass].size() < MAX_FREE_BLOCKS)
+	{
+		pool->m_freeBlocks[sizeClass].push_back(block);
+		pool->m_stats.freeBytes += blockSize;
+		return;
+	}
+
+	free(block);
+	if (pool->m_refs == 0 && pool->m_numUsedBlocks == 0) {
+		delete pool;
+	}
+}
+
+void
+BufferPool::Retain(void)
+{
+	m_refs++;
+}
+
+void
+BufferPool::Release(void)
+{
+	if (--m_refs == 0 && m_numUsedBlocks == 0) {
+		delete this;
+	}
+}
+
+} // namespace node_adabas
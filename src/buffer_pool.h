@@ -0,0 +1,72 @@
+#ifndef NODE_ADABAS_SRC_BUFFER_POOL_H
+#define NODE_ADABAS_SRC_BUFFER_POOL_H
+
+#include <node.h>
+#include <stdint.h>
+#include <vector>
+
+namespace node_adabas {
+
+/*
+ * Pool of memory blocks for Buffers of Adabas buffers (in main thread).
+ * Blocks are grouped by size classes (powers of two), block returns to
+ * the pool when its Buffer is collected. Pool is deleted when it is
+ * released by the owner and commands, which use it, and all blocks are
+ * returned.
+ */
+class BufferPool {
+public:
+	// Sizes of the smallest and the largest pooled blocks.
+	static const size_t MIN_BLOCK_SIZE = 256;
+	static const size_t MAX_BLOCK_SIZE = 64 * 1024;
+	// Maximal number of free blocks of the size class.
+	static const size_t MAX_FREE_BLOCKS = 32;
+
+	/*
+	 * Statistics of the pool.
+	 */
+	struct Stats {
+		// Buffers created from free blocks and from new blocks.
+		uint64_t hits;
+		uint64_t misses;
+		// Bytes of blocks used by Buffers and kept free in the pool.
+		size_t usedBytes;
+		size_t freeBytes;
+	};
+
+private:
+	// Free blocks by size classes.
+	std::vector<std::vector<char*> > m_freeBlocks;
+	Stats m_stats;
+	size_t m_numUsedBlocks;
+	// Number of references (the owner and commands).
+	unsigned int m_refs;
+
+	~BufferPool();
+
+	static size_t BlockSize(unsigned int sizeClass);
+	unsigned int SizeClass(size_t length) const;
+	static void FreeBlock(char* data, void* hint);
+
+public:
+	BufferPool();
+
+	/*
+	 * Creates Buffer of the length with memory of the pooled block.
+	 */
+	v8::Local<v8::Object> NewBuffer(size_t length);
+
+	/*
+	 * Adds reference to the pool, releases the reference.
+	 */
+	void Retain(void);
+	void Release(void);
+
+	const Stats& GetStats(void) const {
+		return m_stats;
+	}
+};
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_BUFFER_POOL_H
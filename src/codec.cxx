@@ -0,0 +1,500 @@
+#include <cstring>
+
+#include "codec.h"
+
+#ifdef CODEC_SSE2
+#include <emmintrin.h>
+#endif // CODEC_SSE2
+
+namespace node_adabas {
+
+namespace codec {
+
+/*
+ * Returns true for the sign half-byte (packed) or zone (unpacked) of
+ * negative decimal.
+ */
+static inline bool
+IsNegativePackedSign(unsigned char sign)
+{
+	return sign == 0x0B || sign == 0x0D;
+}
+
+static inline bool
+IsNegativeUnpackedSign(unsigned char zone)
+{
+	return zone == 0x70 || zone == 0xB0 || zone == 0xD0;
+}
+
+bool
+DecodePacked(const unsigned char* data, uint32_t length, int64_t& value)
+{
+	const uint64_t limit = (0x7FFFFFFFFFFFFFFFULL - 9) / 10;
+	uint64_t number = 0;
+	for (uint32_t i = 0; i < length; i++) {
+		if (number > limit) {
+			return false;
+		}
+		number = number * 10 + (data[i] >> 4);
+		if (i + 1 < length) {
+			if (number > limit) {
+				return false;
+			}
+			number = number * 10 + (data[i] & 0x0F);
+		}
+	}
+
+	bool negative = IsNegativePackedSign(data[length - 1] & 0x0F);
+	value = negative ? -int64_t(number) : int64_t(number);
+	return true;
+}
+
+bool
+DecodeUnpacked(const unsigned char* data, uint32_t length, int64_t& value)
+{
+	const uint64_t limit = (0x7FFFFFFFFFFFFFFFULL - 9) / 10;
+	uint64_t number = 0;
+	for (uint32_t i = 0; i < length; i++) {
+		if (number > limit) {
+			return false;
+		}
+		number = number * 10 + (data[i] & 0x0F);
+	}
+
+	bool negative = IsNegativeUnpackedSign(data[length - 1] & 0xF0);
+	value = negative ? -int64_t(number) : int64_t(number);
+	return true;
+}
+
+/*
+ * Converts digits to string without leading zeros.
+ */
+static std::string
+DigitsToString(const std::string& digits, bool negative)
+{
+	size_t first = digits.find_first_not_of('0');
+	if (first == std::string::npos) {
+		return "0";
+	}
+	return (negative ? "-" : "") + digits.substr(first);
+}
+
+std::string
+PackedToString(const unsigned char* data, uint32_t length)
+{
+	std::string digits;
+	digits.reserve(length * 2);
+	for (uint32_t i = 0; i < length; i++) {
+		digits += char('0' + (data[i] >> 4));
+		if (i + 1 < length) {
+			digits += char('0' + (data[i] & 0x0F));
+		}
+	}
+	return DigitsToString(digits,
+		IsNegativePackedSign(data[length - 1] & 0x0F));
+}
+
+std::string
+UnpackedToString(const unsigned char* data, uint32_t length)
+{
+	std::string digits;
+	digits.reserve(length);
+	for (uint32_t i = 0; i < length; i++) {
+		digits += char('0' + (data[i] & 0x0F));
+	}
+	return DigitsToString(digits,
+		IsNegativeUnpackedSign(data[length - 1] & 0xF0));
+}
+
+/*
+ * Parses string of digits with optional sign.
+ */
+static const char*
+ParseDigits(const std::string& value, std::string& digits, bool& negative)
+{
+	size_t first = 0;
+	negative = false;
+	if (!value.empty() && (value[0] == '-' || value[0] == '+')) {
+		negative = value[0] == '-';
+		first = 1;
+	}
+	if (first == value.size()) {
+		return "value must be a number";
+	}
+	for (size_t i = first; i < value.size(); i++) {
+		if (value[i] < '0' || value[i] > '9') {
+			return "value must be a number";
+		}
+	}
+	digits = value.substr(first);
+	return NULL;
+}
+
+const char*
+EncodePacked(const std::string& value, unsigned char* data,
+	uint32_t length)
+{
+	std::string digits;
+	bool negative;
+	const char* rc = ParseDigits(value, digits, negative);
+	if (rc != NULL) {
+		return rc;
+	}
+
+	// Digits are placed from the right, last half-byte is sign.
+	size_t numDigits = digits.size();
+	size_t pos = numDigits;
+	for (uint32_t i = length; i > 0; i--) {
+		unsigned char low = i == length ? (negative ? 0x0D : 0x0C) :
+			(pos > 0 ? digits[--pos] - '0' : 0);
+		unsigned char high = pos > 0 ? digits[--pos] - '0' : 0;
+		data[i - 1] = (unsigned char) ((high << 4) | low);
+	}
+
+	if (digits.find_first_not_of('0') < pos) {
+		return "value is too large for the packed field";
+	}
+	return NULL;
+}
+
+const char*
+EncodeUnpacked(const std::string& value, unsigned char* data,
+	uint32_t length)
+{
+	std::string digits;
+	bool negative;
+	const char* rc = ParseDigits(value, digits, negative);
+	if (rc != NULL) {
+		return rc;
+	}
+
+	size_t pos = digits.size();
+	for (uint32_t i = length; i > 0; i--) {
+		data[i - 1] = 0x30 | (pos > 0 ? digits[--pos] - '0' : 0);
+	}
+	if (negative) {
+		data[length - 1] = 0x70 | (data[length - 1] & 0x0F);
+	}
+
+	if (digits.find_first_not_of('0') < pos) {
+		return "value is too large for the unpacked field";
+	}
+	return NULL;
+}
+
+const char*
+EncodePacked(int64_t value, unsigned char* data, uint32_t length)
+{
+	bool negative = value < 0;
+	uint64_t number = negative ? 0 - uint64_t(value) : uint64_t(value);
+
+	for (uint32_t i = length; i > 0; i--) {
+		unsigned char low;
+		if (i == length) {
+			low = negative ? 0x0D : 0x0C;
+		} else {
+			low = (unsigned char) (number % 10);
+			number /= 10;
+		}
+		unsigned char high = (unsigned char) (number % 10);
+		number /= 10;
+		data[i - 1] = (unsigned char) ((high << 4) | low);
+	}
+
+	return number == 0 ? NULL : "value is too large for the packed field";
+}
+
+const char*
+EncodeUnpacked(int64_t value, unsigned char* data, uint32_t length)
+{
+	bool negative = value < 0;
+	uint64_t number = negative ? 0 - uint64_t(value) : uint64_t(value);
+
+	for (uint32_t i = length; i > 0; i--) {
+		data[i - 1] = 0x30 | (unsigned char) (number % 10);
+		number /= 10;
+	}
+	if (negative) {
+		data[length - 1] = 0x70 | (data[length - 1] & 0x0F);
+	}
+
+	return number == 0 ? NULL : "value is too large for the unpacked field";
+}
+
+uint64_t
+DecodeBinary(const unsigned char* data, uint32_t length)
+{
+	switch (length) {
+	case 1:
+		return data[0];
+	case 2: {
+		uint16_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	case 4: {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	default: {
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	}
+}
+
+int64_t
+DecodeFixed(const unsigned char* data, uint32_t length)
+{
+	switch (length) {
+	case 1:
+		return int8_t(data[0]);
+	case 2: {
+		int16_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	case 4: {
+		int32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	default: {
+		int64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	}
+}
+
+double
+DecodeFloat(const unsigned char* data, uint32_t length)
+{
+	if (length == 4) {
+		float value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+	double value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+void
+EncodeBinary(uint64_t value, unsigned char* data, uint32_t length)
+{
+	switch (length) {
+	case 1:
+		data[0] = uint8_t(value);
+		break;
+	case 2: {
+		uint16_t number = uint16_t(value);
+		memcpy(data, &number, sizeof(number));
+		break;
+	}
+	case 4: {
+		uint32_t number = uint32_t(value);
+		memcpy(data, &number, sizeof(number));
+		break;
+	}
+	default:
+		memcpy(data, &value, sizeof(value));
+		break;
+	}
+}
+
+void
+EncodeFixed(int64_t value, unsigned char* data, uint32_t length)
+{
+	EncodeBinary(uint64_t(value), data, length);
+}
+
+void
+EncodeFloat(double value, unsigned char* data, uint32_t length)
+{
+	if (length == 4) {
+		float number = float(value);
+		memcpy(data, &number, sizeof(number));
+	} else {
+		memcpy(data, &value, sizeof(value));
+	}
+}
+
+/*
+ * Scalar column kernels.
+ */
+static void
+DecodePackedColumnScalar(const unsigned char* data, size_t stride,
+	uint32_t length, size_t count, double* values)
+{
+	for (size_t i = 0; i < count; i++, data += stride) {
+		int64_t value;
+		DecodePacked(data, length, value);
+		values[i] = double(value);
+	}
+}
+
+static void
+DecodeUnpackedColumnScalar(const unsigned char* data, size_t stride,
+	uint32_t length, size_t count, double* values)
+{
+	for (size_t i = 0; i < count; i++, data += stride) {
+		int64_t value;
+		DecodeUnpacked(data, length, value);
+		values[i] = double(value);
+	}
+}
+
+#ifdef CODEC_SSE2
+
+// Mask bytes: loading 16 bytes at offset N gives N zero bytes followed
+// by 0xFF bytes.
+static const unsigned char maskBytes[32] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/*
+ * Loads 'size' bytes (8 or 16) ending at the end of the field, bytes
+ * before the field are cleared. Bytes before the field are read directly
+ * when they belong to the column ('direct'), otherwise the field is
+ * copied.
+ */
+static inline __m128i
+LoadField(const unsigned char* data, uint32_t length, uint32_t size,
+	bool direct)
+{
+	__m128i x;
+	if (direct) {
+		x = size == 8 ?
+			_mm_loadl_epi64(reinterpret_cast<const __m128i*>(
+				data + length - 8)) :
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(
+				data + length - 16));
+	} else {
+		unsigned char bytes[16] = { 0 };
+		memcpy(bytes + size - length, data, length);
+		x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+	}
+	__m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+		maskBytes + 16 - size + length));
+	return _mm_and_si128(x, mask);
+}
+
+/*
+ * Loads packed decimal (up to 8 bytes) as 16 digits right-aligned (sign
+ * half-byte is dropped).
+ */
+static inline __m128i
+LoadPackedDigits(const unsigned char* data, uint32_t length, bool direct)
+{
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	__m128i x = LoadField(data, length, 8, direct);
+	__m128i high = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+	__m128i low = _mm_and_si128(x, mask);
+	return _mm_slli_si128(_mm_unpacklo_epi8(high, low), 1);
+}
+
+/*
+ * Loads unpacked decimal (up to 16 bytes) as 16 digits right-aligned.
+ */
+static inline __m128i
+LoadUnpackedDigits(const unsigned char* data, uint32_t length, bool direct)
+{
+	__m128i x = LoadField(data, length, 16, direct);
+	return _mm_and_si128(x, _mm_set1_epi8(0x0F));
+}
+
+/*
+ * Converts 16 digits into two 8-digit numbers (32-bit elements 0 and 1):
+ * pairs of digits, then groups of 4 and 8 digits are combined by
+ * multiply-add.
+ */
+static inline __m128i
+ReduceDigits(__m128i digits)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mul10 = _mm_set1_epi32((1 << 16) | 10);
+	const __m128i mul100 = _mm_set1_epi32((1 << 16) | 100);
+	const __m128i mul10000 = _mm_set1_epi32((1 << 16) | 10000);
+
+	__m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(digits, zero), mul10);
+	__m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(digits, zero), mul10);
+	__m128i pairs = _mm_packs_epi32(low, high);
+	__m128i quads = _mm_madd_epi16(pairs, mul100);
+	quads = _mm_packs_epi32(quads, quads);
+	return _mm_madd_epi16(quads, mul10000);
+}
+
+static inline double
+DigitsToDouble(__m128i octets, bool negative)
+{
+	uint32_t high = uint32_t(_mm_cvtsi128_si32(octets));
+	uint32_t low = uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(octets, 4)));
+	double value = double(high) * 100000000.0 + double(low);
+	return negative ? -value : value;
+}
+
+#endif // CODEC_SSE2
+
+void
+DecodePackedColumn(const unsigned char* data, size_t stride,
+	uint32_t length, size_t count, double* values)
+{
+#ifdef CODEC_SSE2
+	if (length > MAX_PACKED_COLUMN_LENGTH) {
+		DecodePackedColumnScalar(data, stride, length, count, values);
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const unsigned char* field = data + i * stride;
+		values[i] = DigitsToDouble(
+			ReduceDigits(LoadPackedDigits(field, length,
+				i * stride + length >= 8)),
+			IsNegativePackedSign(field[length - 1] & 0x0F));
+	}
+#else
+	DecodePackedColumnScalar(data, stride, length, count, values);
+#endif // CODEC_SSE2
+}
+
+void
+DecodeUnpackedColumn(const unsigned char* data, size_t stride,
+	uint32_t length, size_t count, double* values)
+{
+#ifdef CODEC_SSE2
+	if (length > MAX_UNPACKED_COLUMN_LENGTH) {
+		DecodeUnpackedColumnScalar(data, stride, length, count, values);
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const unsigned char* field = data + i * stride;
+		values[i] = DigitsToDouble(
+			ReduceDigits(LoadUnpackedDigits(field, length,
+				i * stride + length >= 16)),
+			IsNegativeUnpackedSign(field[length - 1] & 0xF0));
+	}
+#else
+	DecodeUnpackedColumnScalar(data, stride, length, count, values);
+#endif // CODEC_SSE2
+}
+
+const char*
+SimdLevel(void)
+{
+#if defined(CODEC_SSE2)
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+} // namespace codec
+
+} // namespace node_adabas
@@ -0,0 +1,93 @@
+#ifndef NODE_ADABAS_SRC_CODEC_H
+#define NODE_ADABAS_SRC_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/*
+ * SIMD kernels of the codec (CODEC_NO_SIMD disables them).
+ */
+#ifndef CODEC_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CODEC_SSE2
+#endif // __SSE2__
+#endif // CODEC_NO_SIMD
+
+namespace node_adabas {
+
+/*
+ * Conversions of Adabas field formats: P (packed decimal), U (unpacked
+ * decimal), B (binary), F (fixed point) and G (floating point). Binary,
+ * fixed and floating point values are in native byte order.
+ */
+namespace codec {
+
+// Maximal length of the field decoded by the column kernels (15 digits,
+// longer decimals may exceed 2^53).
+const uint32_t MAX_PACKED_COLUMN_LENGTH = 8;
+const uint32_t MAX_UNPACKED_COLUMN_LENGTH = 15;
+
+// Maximal integer, which is exactly representable by double.
+const int64_t MAX_EXACT_DOUBLE = 9007199254740992LL;
+
+/*
+ * Decodes decimal into integer. Returns false when the value doesn't fit
+ * into 64-bit integer (use *ToString() functions then).
+ */
+bool DecodePacked(const unsigned char* data, uint32_t length, int64_t& value);
+bool DecodeUnpacked(const unsigned char* data, uint32_t length,
+	int64_t& value);
+
+/*
+ * Decodes decimal into string of digits (with sign '-').
+ */
+std::string PackedToString(const unsigned char* data, uint32_t length);
+std::string UnpackedToString(const unsigned char* data, uint32_t length);
+
+/*
+ * Encodes integer or string of digits (with optional sign) into decimal.
+ * Returns error message or NULL.
+ */
+const char* EncodePacked(int64_t value, unsigned char* data,
+	uint32_t length);
+const char* EncodeUnpacked(int64_t value, unsigned char* data,
+	uint32_t length);
+const char* EncodePacked(const std::string& value, unsigned char* data,
+	uint32_t length);
+const char* EncodeUnpacked(const std::string& value, unsigned char* data,
+	uint32_t length);
+
+/*
+ * Decodes/encodes binary (unsigned), fixed point (signed) and floating
+ * point values (length of binary and fixed point is 1, 2, 4 or 8, length
+ * of floating point is 4 or 8).
+ */
+uint64_t DecodeBinary(const unsigned char* data, uint32_t length);
+int64_t DecodeFixed(const unsigned char* data, uint32_t length);
+double DecodeFloat(const unsigned char* data, uint32_t length);
+void EncodeBinary(uint64_t value, unsigned char* data, uint32_t length);
+void EncodeFixed(int64_t value, unsigned char* data, uint32_t length);
+void EncodeFloat(double value, unsigned char* data, uint32_t length);
+
+/*
+ * Column kernels: decode the field with the same offset in 'count'
+ * records located 'stride' bytes apart. Field length must not exceed
+ * MAX_*_COLUMN_LENGTH (so all values are exact).
+ */
+void DecodePackedColumn(const unsigned char* data, size_t stride,
+	uint32_t length, size_t count, double* values);
+void DecodeUnpackedColumn(const unsigned char* data, size_t stride,
+	uint32_t length, size_t count, double* values);
+
+/*
+ * Returns name of the SIMD kernels used: 'sse2' or 'scalar'.
+ */
+const char* SimdLevel(void);
+
+} // namespace codec
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_CODEC_H
@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <cstring>
 #include <iomanip>
 #include <node.h>
@@ -5,11 +6,47 @@
 #include <sstream>
 
 #include "command.h"
+#include "transcode.h"
 #include "v8_helpers.h"
 
 namespace node_adabas {
 
 v8::Persistent<v8::Function> Command::constructor;
+v8::Persistent<v8::String> Command::fieldSymbols[NUM_FIELDS];
+
+/*
+ * Property names and constants of masks (get()) of the fields in the
+ * order of field codes.
+ */
+static const char* fieldNames[][2] = {
+	{ "commandCode", "FIELD_COMMAND_CODE" },
+	{ "commandId", "FIELD_COMMAND_ID" },
+	{ "dbId", "FIELD_DB_ID" },
+	{ "fileNo", "FIELD_FILE_NO" },
+	{ "returnCode", "FIELD_RETURN_CODE" },
+	{ "isn", "FIELD_ISN" },
+	{ "isnLowerLimit", "FIELD_ISN_LOWER_LIMIT" },
+	{ "isnQuantity", "FIELD_ISN_QUANTITY" },
+	{ "formatBufferLength", "FIELD_FORMAT_BUFFER_LENGTH" },
+	{ "recordBufferLength", "FIELD_RECORD_BUFFER_LENGTH" },
+	{ "searchBufferLength", "FIELD_SEARCH_BUFFER_LENGTH" },
+	{ "valueBufferLength", "FIELD_VALUE_BUFFER_LENGTH" },
+	{ "isnBufferLength", "FIELD_ISN_BUFFER_LENGTH" },
+	{ "commandOption1", "FIELD_COMMAND_OPTION1" },
+	{ "commandOption2", "FIELD_COMMAND_OPTION2" },
+	{ "addition1", "FIELD_ADDITION1" },
+	{ "addition2", "FIELD_ADDITION2" },
+	{ "addition3", "FIELD_ADDITION3" },
+	{ "addition4", "FIELD_ADDITION4" },
+	{ "addition5", "FIELD_ADDITION5" },
+	{ "commandTime", "FIELD_COMMAND_TIME" },
+	{ "userArea", "FIELD_USER_AREA" },
+	{ "formatBuffer", "FIELD_FORMAT_BUFFER" },
+	{ "recordBuffer", "FIELD_RECORD_BUFFER" },
+	{ "searchBuffer", "FIELD_SEARCH_BUFFER" },
+	{ "valueBuffer", "FIELD_VALUE_BUFFER" },
+	{ "isnBuffer", "FIELD_ISN_BUFFER" }
+};
 
 /*
  * Constructor.
@@ -20,6 +57,37 @@ Command::Command() : ObjectWrap()
 	for (int i = 0; i < 5; i++) {
 		m_buffers[i] = NULL;
 	}
+	m_bufferPool = NULL;
+	m_session = -1;
+	m_lastCallTime = 0;
+	m_multiFetch = false;
+	m_multiFetchLimit = 0;
+	m_multiFetchTargetTime = 0;
+	m_multiFetchRecordLength = 0;
+}
+
+/*
+ * Destructor.
+ */
+Command::~Command()
+{
+	for (int i = 0; i < 5; i++) {
+		m_bufferObjects[i].Dispose();
+	}
+	SetBufferPool(NULL);
+}
+
+/*
+ * Adds offset and size of the control block field to the layout.
+ */
+static void
+SetFieldLayout(v8::Local<v8::Object> fields, const char* name,
+	size_t offset, size_t size)
+{
+	v8::Local<v8::Array> field = v8::Array::New(2);
+	field->Set(0, v8::Integer::NewFromUnsigned(uint32_t(offset)));
+	field->Set(1, v8::Integer::NewFromUnsigned(uint32_t(size)));
+	fields->Set(v8::String::NewSymbol(name), field);
 }
 
 /*
@@ -36,6 +104,9 @@ Command::Initialize(v8::Handle<v8::Object> exports)
 	// Prototype.
 	V8_METHOD("clear", Clear);
 	V8_METHOD("toString", ToString);
+	V8_METHOD("clone", Clone);
+	V8_METHOD("set", Set);
+	V8_METHOD("get", Get);
 	V8_METHOD("setCommandCode", SetCommandCode);
 	V8_METHOD("setCommandId", SetCommandId);
 	V8_METHOD("setDbId", SetDbId);
@@ -63,6 +134,8 @@ Command::Initialize(v8::Handle<v8::Object> exports)
 	V8_METHOD("setSearchBuffer", SetSearchBuffer);
 	V8_METHOD("setValueBuffer", SetValueBuffer);
 	V8_METHOD("setIsnBuffer", SetIsnBuffer);
+	V8_METHOD("setSession", SetSession);
+	V8_METHOD("setMultiFetch", SetMultiFetch);
 	V8_METHOD("getCommandCode", GetCommandCode);
 	V8_METHOD("getCommandId", GetCommandId);
 	V8_METHOD("getDbId", GetDbId);
@@ -90,9 +163,66 @@ Command::Initialize(v8::Handle<v8::Object> exports)
 	V8_METHOD("getSearchBuffer", GetSearchBuffer);
 	V8_METHOD("getValueBuffer", GetValueBuffer);
 	V8_METHOD("getIsnBuffer", GetIsnBuffer);
+	V8_METHOD("getSession", GetSession);
+	V8_METHOD("getMultiFetch", GetMultiFetch);
+	V8_METHOD("getControlBlock", GetControlBlock);
 
 	constructor = v8::Persistent<v8::Function>::New(t->GetFunction());
 	exports->Set(v8::String::NewSymbol("Command"), constructor);
+
+	for (int field = 0; field < NUM_FIELDS; field++) {
+		fieldSymbols[field] = v8::Persistent<v8::String>::New(
+			v8::String::NewSymbol(fieldNames[field][0]));
+		V8_CONSTANT(fieldNames[field][1], 1 << field);
+	}
+
+	// Layout of the control block: offsets and sizes of the fields.
+	v8::Local<v8::Object> fields = v8::Object::New();
+	SetFieldLayout(fields, "commandCode", offsetof(CB_PAR, cb_cmd_code),
+		sizeof(((CB_PAR*) 0)->cb_cmd_code));
+	SetFieldLayout(fields, "commandId", offsetof(CB_PAR, cb_cmd_id),
+		L_CID);
+	SetFieldLayout(fields, "fileNo", offsetof(CB_PAR, cb_file_nr), 1);
+	SetFieldLayout(fields, "dbId", offsetof(CB_PAR, cb_db_id), 1);
+	SetFieldLayout(fields, "returnCode",
+		offsetof(CB_PAR, cb_return_code), 2);
+	SetFieldLayout(fields, "isn", offsetof(CB_PAR, cb_isn), 4);
+	SetFieldLayout(fields, "isnLowerLimit", offsetof(CB_PAR, cb_isn_ll), 4);
+	SetFieldLayout(fields, "isnQuantity",
+		offsetof(CB_PAR, cb_isn_quantity), 4);
+	SetFieldLayout(fields, "formatBufferLength",
+		offsetof(CB_PAR, cb_fmt_buf_lng), 2);
+	SetFieldLayout(fields, "recordBufferLength",
+		offsetof(CB_PAR, cb_rec_buf_lng), 2);
+	SetFieldLayout(fields, "searchBufferLength",
+		offsetof(CB_PAR, cb_sea_buf_lng), 2);
+	SetFieldLayout(fields, "valueBufferLength",
+		offsetof(CB_PAR, cb_val_buf_lng), 2);
+	SetFieldLayout(fields, "isnBufferLength",
+		offsetof(CB_PAR, cb_isn_buf_lng), 2);
+	SetFieldLayout(fields, "commandOption1", offsetof(CB_PAR, cb_cop1), 1);
+	SetFieldLayout(fields, "commandOption2", offsetof(CB_PAR, cb_cop2), 1);
+	SetFieldLayout(fields, "addition1", offsetof(CB_PAR, cb_add1),
+		CB_L_AD1);
+	SetFieldLayout(fields, "addition2", offsetof(CB_PAR, cb_add2),
+		CB_L_AD2);
+	SetFieldLayout(fields, "addition3", offsetof(CB_PAR, cb_add3),
+		CB_L_AD3);
+	SetFieldLayout(fields, "addition4", offsetof(CB_PAR, cb_add4),
+		CB_L_AD4);
+	SetFieldLayout(fields, "addition5", offsetof(CB_PAR, cb_add5),
+		CB_L_AD5);
+	SetFieldLayout(fields, "commandTime", offsetof(CB_PAR, cb_cmd_time), 4);
+	SetFieldLayout(fields, "userArea", offsetof(CB_PAR, cb_user_area),
+		sizeof(((CB_PAR*) 0)->cb_user_area));
+
+	v8::Local<v8::Object> layout = v8::Object::New();
+	layout->Set(v8::String::NewSymbol("size"),
+		v8::Integer::NewFromUnsigned(sizeof(CB_PAR)));
+	layout->Set(v8::String::NewSymbol("fields"), fields);
+	exports->Set(v8::String::NewSymbol("controlBlockLayout"), layout,
+		static_cast<v8::PropertyAttribute>(
+			v8::ReadOnly | v8::DontDelete));
 }
 
 /*
@@ -122,6 +252,167 @@ Command::NewInstance(const v8::Arguments& args)
 	return scope.Close(constructor->NewInstance(0, NULL));
 }
 
+/*
+ * Returns the wrapped command or NULL if value is not a command.
+ */
+Command*
+Command::FromValue(v8::Handle<v8::Value> value)
+{
+	if (!value->IsObject()) {
+		return NULL;
+	}
+
+	v8::Handle<v8::Object> commandObject = value->ToObject();
+	std::string constructorName(*v8::String::Utf8Value(
+		commandObject->GetConstructorName()));
+	if (constructorName != "Command") {
+		return NULL;
+	}
+	return ObjectWrap::Unwrap<Command>(commandObject);
+}
+
+/*
+ * Sets buffer of the command (0 - format buffer, 1 - record buffer,
+ * 2 - search buffer, 3 - value buffer, 4 - ISN buffer). Command keeps
+ * reference to the Buffer, so it isn't collected while the command may
+ * be executed.
+ */
+void
+Command::SetBuffer(unsigned int index, v8::Handle<v8::Object> buffer)
+{
+	m_bufferObjects[index].Dispose();
+	m_bufferObjects[index] = v8::Persistent<v8::Object>::New(buffer);
+	m_buffers[index] = node::Buffer::Data(buffer);
+}
+
+/*
+ * Returns buffer of the command or null.
+ */
+v8::Local<v8::Value>
+Command::GetBuffer(unsigned int index)
+{
+	if (m_bufferObjects[index].IsEmpty()) {
+		return v8::Local<v8::Value>::New(v8::Null());
+	}
+	return v8::Local<v8::Object>::New(m_bufferObjects[index]);
+}
+
+/*
+ * Sets length of the buffer in the control block.
+ */
+void
+Command::SetBufferLength(unsigned int index, unsigned short length)
+{
+	switch (index) {
+	case 0:
+		m_cb.cb_fmt_buf_lng = length;
+		break;
+	case 1:
+		m_cb.cb_rec_buf_lng = length;
+		break;
+	case 2:
+		m_cb.cb_sea_buf_lng = length;
+		break;
+	case 3:
+		m_cb.cb_val_buf_lng = length;
+		break;
+	case 4:
+		m_cb.cb_isn_buf_lng = length;
+		break;
+	}
+}
+
+/*
+ * Returns length of the buffer in the control block.
+ */
+unsigned short
+Command::GetBufferLength(unsigned int index) const
+{
+	switch (index) {
+	case 0:
+		return m_cb.cb_fmt_buf_lng;
+	case 1:
+		return m_cb.cb_rec_buf_lng;
+	case 2:
+		return m_cb.cb_sea_buf_lng;
+	case 3:
+		return m_cb.cb_val_buf_lng;
+	default:
+		return m_cb.cb_isn_buf_lng;
+	}
+}
+
+/*
+ * Sets pool of the Adabas instance, which owns the command.
+ */
+void
+Command::SetBufferPool(BufferPool* pool)
+{
+	if (pool != NULL) {
+		pool->Retain();
+	}
+	if (m_bufferPool != NULL) {
+		m_bufferPool->Release();
+	}
+	m_bufferPool = pool;
+}
+
+/*
+ * Returns view of the first ISNs in the buffer as array of unsigned
+ * 32-bit integers (ISNs are not copied, view keeps buffer alive as
+ * property 'buffer').
+ */
+v8::Local<v8::Object>
+Command::NewIsnArray(v8::Handle<v8::Object> buffer, uint32_t numIsns)
+{
+	v8::Local<v8::Object> isns = v8::Object::New();
+	isns->SetIndexedPropertiesToExternalArrayData(
+		node::Buffer::Data(buffer), v8::kExternalUnsignedIntArray,
+		numIsns);
+	isns->Set(v8::String::NewSymbol("length"),
+		v8::Integer::NewFromUnsigned(numIsns),
+		static_cast<v8::PropertyAttribute>(
+			v8::ReadOnly | v8::DontEnum | v8::DontDelete));
+	isns->Set(v8::String::NewSymbol("buffer"), buffer,
+		static_cast<v8::PropertyAttribute>(
+			v8::ReadOnly | v8::DontEnum | v8::DontDelete));
+	return isns;
+}
+
+/*
+ * Memory of the control block is owned by the command.
+ */
+static void
+KeepControlBlock(char* data, void* hint)
+{
+}
+
+/*
+ * Returns Buffer, which shares memory with the control block (fields are
+ * in native byte order, see controlBlockLayout). Buffer keeps the command
+ * alive as property 'command'.
+ */
+v8::Handle<v8::Value>
+Command::GetControlBlock(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Command* self = ObjectWrap::Unwrap<Command>(args.This());
+
+	if (args.Length() != 0) {
+                return V8_ERROR("wrong number of arguments");
+	}
+
+	node::Buffer* buffer = node::Buffer::New((char*) &self->m_cb,
+		sizeof(CB_PAR), KeepControlBlock, NULL);
+	v8::Local<v8::Object> bufferObject =
+		v8::Local<v8::Object>::New(buffer->handle_);
+	bufferObject->Set(v8::String::NewSymbol("command"), args.This(),
+		static_cast<v8::PropertyAttribute>(
+			v8::ReadOnly | v8::DontEnum | v8::DontDelete));
+
+	return scope.Close(bufferObject);
+}
+
 /*
  * Clears command fields and buffers.
  */
@@ -134,11 +425,109 @@ Command::Clear(const v8::Arguments& args)
 	memset(&self->m_cb, 0, sizeof(CB_PAR));
 	for (int i = 0; i < 5; i++) {
 		self->m_buffers[i] = NULL;
+		self->m_bufferObjects[i].Dispose();
+		self->m_bufferObjects[i].Clear();
 	}
+	self->m_multiFetch = false;
 
 	return scope.Close(args.This());
 }
 
+/*
+ * Copies control block, buffers and settings of the command (template)
+ * into the target command or into the new command: clone([target]).
+ * Format and search buffers are shared with the template. Record, value
+ * and ISN buffers are private: target keeps its own buffer if it is long
+ * enough, otherwise new buffer is taken from the pool of the owning
+ * instance (see adopt()). Template without the buffer gives buffer of
+ * the length in the control block, template buffer is default contents
+ * of record and value buffers (only the length in the control block is
+ * copied). Returns the target.
+ */
+v8::Handle<v8::Value>
+Command::Clone(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Command* self = ObjectWrap::Unwrap<Command>(args.This());
+
+	if (args.Length() > 1) {
+                return V8_ERROR("wrong number of arguments");
+	}
+
+	v8::Local<v8::Object> targetObject;
+	if (args.Length() == 1) {
+		if (FromValue(args[0]) == NULL) {
+			return V8_ERROR("argument must be an Adabas control block");
+		}
+		targetObject = args[0]->ToObject();
+	} else {
+		targetObject = constructor->NewInstance(0, NULL);
+	}
+	Command* target = ObjectWrap::Unwrap<Command>(targetObject);
+	if (target == self) {
+		return scope.Close(targetObject);
+	}
+
+	BufferPool* pool = self->m_bufferPool != NULL ?
+		self->m_bufferPool : target->m_bufferPool;
+	target->SetBufferPool(pool);
+
+	memcpy(&target->m_cb, &self->m_cb, sizeof(CB_PAR));
+	for (unsigned int i = 0; i < 5; i++) {
+		// Format and search buffers are only read by Adabas.
+		bool shared = i == 0 || i == 2;
+		bool hasContents = !self->m_bufferObjects[i].IsEmpty();
+		size_t length = 0;
+		if (hasContents) {
+			length = node::Buffer::Length(self->m_bufferObjects[i]);
+		} else if (!shared) {
+			length = self->GetBufferLength(i);
+		}
+		if (length == 0) {
+			target->m_buffers[i] = NULL;
+			target->m_bufferObjects[i].Dispose();
+			target->m_bufferObjects[i].Clear();
+			continue;
+		}
+		if (shared) {
+			target->SetBuffer(i, self->m_bufferObjects[i]);
+			continue;
+		}
+
+		if (target->m_bufferObjects[i].IsEmpty() ||
+			target->m_bufferObjects[i] == self->m_bufferObjects[i] ||
+			node::Buffer::Length(target->m_bufferObjects[i]) < length)
+		{
+			v8::Local<v8::Object> buffer;
+			if (pool != NULL) {
+				buffer = pool->NewBuffer(length);
+			} else {
+				buffer = v8::Local<v8::Object>::New(
+					node::Buffer::New(length)->handle_);
+			}
+			if (buffer.IsEmpty()) {
+				return ThrowException(
+					node::ErrnoException(ENOMEM, "Clone"));
+			}
+			target->SetBuffer(i, buffer);
+		}
+		if (hasContents && i != 4) {
+			size_t copyLength = self->GetBufferLength(i);
+			memcpy(target->m_buffers[i], self->m_buffers[i],
+				copyLength < length ? copyLength : length);
+		}
+	}
+
+	target->m_session = self->m_session;
+	target->m_lastCallTime = 0;
+	target->m_multiFetch = self->m_multiFetch;
+	target->m_multiFetchLimit = self->m_multiFetchLimit;
+	target->m_multiFetchTargetTime = self->m_multiFetchTargetTime;
+	target->m_multiFetchRecordLength = self->m_multiFetchRecordLength;
+
+	return scope.Close(targetObject);
+}
+
 /*
  * Convert binary data to ASCII string.
  */
@@ -282,18 +671,15 @@ SetField(unsigned char* field, unsigned int size,
 		return "argument must be a string";
 	}
 
-	v8::String::Value stringValue(value);
-	uint16_t* buffer = *stringValue;
-	unsigned int bufferLength = stringValue.length();
-	if (bufferLength != size) {
+	if (v8::Local<v8::String>::Cast(value)->Length() != int(size)) {
 		return "invalid length of the argument";
 	}
 
-	for (unsigned int i = 0; i < size; i++) {
-		field[i] = uint8_t(buffer[i]);
-	}
-
-	return NULL;
+	// Control block is interpreted by the Adabas link routine, so its
+	// alphanumeric fields are always Latin-1.
+	size_t length;
+	return transcode::WriteString(transcode::LATIN1, value, field, size,
+		length);
 }
 
 static const char*
@@ -317,15 +703,16 @@ SetFieldArray(unsigned char* field, unsigned int size,
 }
 
 /*
- * Sets pointer to buffer data.
+ * Sets buffer of the command.
  */
 static const char*
-SetBuffer(void** field, const v8::Local<v8::Value> &value)
+SetBufferField(Command* self, unsigned int index,
+	const v8::Local<v8::Value> &value)
 {
 	if (!node::Buffer::HasInstance(value)) {
 		return "argument must be a buffer";
 	}
-	*field = node::Buffer::Data(value->ToObject());
+	self->SetBuffer(index, value->ToObject());
 	return NULL;
 }
 
@@ -353,7 +740,7 @@ GetField(const unsigned int& field)
 static v8::Local<v8::String>
 GetField(const unsigned char* field, unsigned int size)
 {
-	return v8::String::New((char*)(field), size);
+	return transcode::NewString(transcode::LATIN1, field, size);
 }
 
 static v8::Local<v8::Array>
@@ -785,7 +1172,7 @@ Command::SetFormatBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	const char* rc = SetBuffer(&self->m_buffers[0], args[0]);
+	const char* rc = SetBufferField(self, 0, args[0]);
 	if (rc) {
                 return V8_ERROR(rc);
 	}
@@ -803,7 +1190,7 @@ Command::SetRecordBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	const char* rc = SetBuffer(&self->m_buffers[1], args[0]);
+	const char* rc = SetBufferField(self, 1, args[0]);
 	if (rc) {
                 return V8_ERROR(rc);
 	}
@@ -821,7 +1208,7 @@ Command::SetSearchBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	const char* rc = SetBuffer(&self->m_buffers[2], args[0]);
+	const char* rc = SetBufferField(self, 2, args[0]);
 	if (rc) {
                 return V8_ERROR(rc);
 	}
@@ -839,7 +1226,7 @@ Command::SetValueBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	const char* rc = SetBuffer(&self->m_buffers[3], args[0]);
+	const char* rc = SetBufferField(self, 3, args[0]);
 	if (rc) {
                 return V8_ERROR(rc);
 	}
@@ -857,7 +1244,7 @@ Command::SetIsnBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	const char* rc = SetBuffer(&self->m_buffers[4], args[0]);
+	const char* rc = SetBufferField(self, 4, args[0]);
 	if (rc) {
                 return V8_ERROR(rc);
 	}
@@ -865,6 +1252,69 @@ Command::SetIsnBuffer(const v8::Arguments& args)
 	return scope.Close(args.This());
 }
 
+/*
+ * Sets session of the Adabas instance, which executes the command
+ * (-1 - command has no session). Session is not reset by clear().
+ */
+v8::Handle<v8::Value>
+Command::SetSession(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Command* self = ObjectWrap::Unwrap<Command>(args.This());
+
+	if (args.Length() != 1) {
+                return V8_ERROR("wrong number of arguments");
+	}
+
+	if (!args[0]->IsInt32() || args[0]->Int32Value() < -1) {
+                return V8_ERROR("argument must be a session number or -1");
+	}
+	self->m_session = args[0]->Int32Value();
+
+	return scope.Close(args.This());
+}
+
+/*
+ * Switches the command to multi-fetch mode: setMultiFetch(limit
+ * [, targetTimeMs]). Limit is the maximal number of records per call,
+ * 0 - number of records is tuned after each call by getMultiFetch() from
+ * the average record length, the size of buffers and the call time
+ * (which should not exceed targetTimeMs).
+ */
+v8::Handle<v8::Value>
+Command::SetMultiFetch(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Command* self = ObjectWrap::Unwrap<Command>(args.This());
+
+	unsigned int numArgs = args.Length();
+	if (numArgs < 1 || numArgs > 2) {
+                return V8_ERROR("wrong number of arguments");
+	}
+
+	if (!args[0]->IsUint32()) {
+                return V8_ERROR("argument must be a number of records");
+	}
+	if (numArgs == 2 && !args[1]->IsUint32()) {
+                return V8_ERROR("argument must be a time in milliseconds");
+	}
+
+	self->m_multiFetch = true;
+	self->m_multiFetchLimit = args[0]->Uint32Value();
+	self->m_multiFetchTargetTime =
+		numArgs == 2 ? uint64_t(args[1]->Uint32Value()) * 1000 : 0;
+	self->m_multiFetchRecordLength = 0;
+
+	self->m_cb.cb_cop1 = ADA_MULTI_FETCH;
+	if (self->m_multiFetchLimit > 0) {
+		self->m_cb.cb_isn_ll = self->m_multiFetchLimit;
+	} else {
+		self->TuneMultiFetch(0, 0);
+	}
+
+	return scope.Close(args.This());
+}
+
 v8::Handle<v8::Value>
 Command::GetCommandCode(const v8::Arguments& args)
 {
@@ -1172,7 +1622,7 @@ Command::GetFormatBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	return scope.Close(v8::String::New("not implemented"));
+	return scope.Close(self->GetBuffer(0));
 }
 
 v8::Handle<v8::Value>
@@ -1185,7 +1635,7 @@ Command::GetRecordBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	return scope.Close(v8::String::New("not implemented"));
+	return scope.Close(self->GetBuffer(1));
 }
 
 v8::Handle<v8::Value>
@@ -1198,7 +1648,7 @@ Command::GetSearchBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	return scope.Close(v8::String::New("not implemented"));
+	return scope.Close(self->GetBuffer(2));
 }
 
 v8::Handle<v8::Value>
@@ -1211,7 +1661,7 @@ Command::GetValueBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	return scope.Close(v8::String::New("not implemented"));
+	return scope.Close(self->GetBuffer(3));
 }
 
 v8::Handle<v8::Value>
@@ -1224,7 +1674,439 @@ Command::GetIsnBuffer(const v8::Arguments& args)
                 return V8_ERROR("wrong number of arguments");
 	}
 
-	return scope.Close(v8::String::New("not implemented"));
+	if (self->m_bufferObjects[4].IsEmpty()) {
+		return scope.Close(v8::Null());
+	}
+
+	// View covers the ISN buffer length, but not more than the buffer.
+	v8::Local<v8::Object> buffer =
+		v8::Local<v8::Object>::New(self->m_bufferObjects[4]);
+	size_t numIsns = self->m_cb.cb_isn_buf_lng;
+	if (numIsns > node::Buffer::Length(buffer)) {
+		numIsns = node::Buffer::Length(buffer);
+	}
+	numIsns /= sizeof(uint32_t);
+
+	return scope.Close(NewIsnArray(buffer, uint32_t(numIsns)));
+}
+
+v8::Handle<v8::Value>
+Command::GetSession(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Command* self = ObjectWrap::Unwrap<Command>(args.This());
+
+	if (args.Length() != 0) {
+                return V8_ERROR("wrong number of arguments");
+	}
+
+	return scope.Close(v8::Integer::New(self->m_session));
+}
+
+/*
+ * Size of the multi-fetch header and the element of the ISN buffer:
+ * number of records, then per record { record length, response code,
+ * ISN, ISN quantity }.
+ */
+#define MULTI_FETCH_HEADER_SIZE 4
+#define MULTI_FETCH_ELEMENT_SIZE 16
+
+/*
+ * Tunes number of records per multi-fetch call by the records of the
+ * last call.
+ */
+void
+Command::TuneMultiFetch(uint32_t numRecords, size_t recordsLength)
+{
+	if (numRecords > 0) {
+		double recordLength = double(recordsLength) / numRecords;
+		m_multiFetchRecordLength = m_multiFetchRecordLength == 0 ?
+			recordLength :
+			(m_multiFetchRecordLength + recordLength) / 2;
+	}
+
+	// Limits of the ISN buffer and the record buffer.
+	uint32_t limit = 1;
+	if (m_cb.cb_isn_buf_lng > MULTI_FETCH_HEADER_SIZE) {
+		limit = (m_cb.cb_isn_buf_lng - MULTI_FETCH_HEADER_SIZE) /
+			MULTI_FETCH_ELEMENT_SIZE;
+	}
+	if (m_multiFetchRecordLength >= 1) {
+		uint32_t recordLimit = uint32_t(
+			m_cb.cb_rec_buf_lng / m_multiFetchRecordLength);
+		if (recordLimit < limit) {
+			limit = recordLimit;
+		}
+	}
+
+	// Limit of the call time.
+	if (m_multiFetchTargetTime > 0 && numRecords > 0 &&
+		m_lastCallTime > 0)
+	{
+		double recordTime = double(m_lastCallTime) / 1000 / numRecords;
+		double timeLimit = double(m_multiFetchTargetTime) / recordTime;
+		if (timeLimit < limit) {
+			limit = uint32_t(timeLimit);
+		}
+	}
+
+	m_cb.cb_isn_ll = limit > 0 ? limit : 1;
+}
+
+/*
+ * Walks the ISN buffer and the record buffer returned by multi-fetch
+ * call: getMultiFetch([recordBuffer]). Returns array of records
+ * '{ isn, rc, offset, length }', where offset and length locate the
+ * record in the record buffer. If record buffer is passed, records
+ * contain also 'slice' - view of the record buffer (without copying).
+ */
+v8::Handle<v8::Value>
+Command::GetMultiFetch(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Command* self = ObjectWrap::Unwrap<Command>(args.This());
+
+	unsigned int numArgs = args.Length();
+	if (numArgs > 1) {
+                return V8_ERROR("wrong number of arguments");
+	}
+
+	v8::Local<v8::Object> recordBuffer;
+	v8::Local<v8::Function> slice;
+	if (numArgs == 1) {
+		if (!node::Buffer::HasInstance(args[0])) {
+                        return V8_ERROR("argument must be a buffer");
+		}
+		recordBuffer = args[0]->ToObject();
+		if (node::Buffer::Data(recordBuffer) != self->m_buffers[1]) {
+                        return V8_ERROR(
+				"argument must be the record buffer of the command");
+		}
+		slice = v8::Local<v8::Function>::Cast(
+			recordBuffer->Get(v8::String::NewSymbol("slice")));
+	}
+
+	// Lengths in the control block are bounded by the bound buffers.
+	const unsigned char* isnBuffer =
+		static_cast<unsigned char*>(self->m_buffers[4]);
+	size_t isnBufferLength = self->m_cb.cb_isn_buf_lng;
+	if (isnBuffer != NULL &&
+		node::Buffer::Length(self->m_bufferObjects[4]) < isnBufferLength)
+	{
+		isnBufferLength = node::Buffer::Length(self->m_bufferObjects[4]);
+	}
+	size_t recordBufferLength = 0;
+	if (self->m_buffers[1] != NULL) {
+		recordBufferLength = node::Buffer::Length(self->m_bufferObjects[1]);
+		if (recordBufferLength > self->m_cb.cb_rec_buf_lng) {
+			recordBufferLength = self->m_cb.cb_rec_buf_lng;
+		}
+	}
+	if (isnBuffer == NULL || isnBufferLength < MULTI_FETCH_HEADER_SIZE) {
+                return V8_ERROR("command has no ISN buffer");
+	}
+
+	uint32_t numRecords;
+	memcpy(&numRecords, isnBuffer, sizeof(uint32_t));
+	uint32_t maxRecords = uint32_t((isnBufferLength -
+		MULTI_FETCH_HEADER_SIZE) / MULTI_FETCH_ELEMENT_SIZE);
+	if (numRecords > maxRecords) {
+                return V8_ERROR("invalid number of records in ISN buffer");
+	}
+
+	v8::Local<v8::String> isnSymbol = v8::String::NewSymbol("isn");
+	v8::Local<v8::String> rcSymbol = v8::String::NewSymbol("rc");
+	v8::Local<v8::String> offsetSymbol = v8::String::NewSymbol("offset");
+	v8::Local<v8::String> lengthSymbol = v8::String::NewSymbol("length");
+	v8::Local<v8::String> sliceSymbol = v8::String::NewSymbol("slice");
+
+	v8::Local<v8::Array> records = v8::Array::New(numRecords);
+	size_t offset = 0;
+	const unsigned char* element = isnBuffer + MULTI_FETCH_HEADER_SIZE;
+	for (uint32_t i = 0; i < numRecords; i++) {
+		uint32_t fields[4];
+		memcpy(fields, element, sizeof(fields));
+		element += MULTI_FETCH_ELEMENT_SIZE;
+
+		uint32_t length = fields[0];
+		if (offset + length > recordBufferLength) {
+                        return V8_ERROR("record is out of the record buffer");
+		}
+
+		v8::Local<v8::Object> record = v8::Object::New();
+		record->Set(isnSymbol, v8::Integer::NewFromUnsigned(fields[2]));
+		record->Set(rcSymbol, v8::Integer::NewFromUnsigned(fields[1]));
+		record->Set(offsetSymbol, v8::Integer::NewFromUnsigned(offset));
+		record->Set(lengthSymbol, v8::Integer::NewFromUnsigned(length));
+		if (!slice.IsEmpty()) {
+			v8::Local<v8::Value> sliceArgs[] = {
+				v8::Integer::NewFromUnsigned(offset),
+				v8::Integer::NewFromUnsigned(offset + length)
+			};
+			record->Set(sliceSymbol,
+				slice->Call(recordBuffer, 2, sliceArgs));
+		}
+		records->Set(i, record);
+
+		offset += length;
+	}
+
+	if (self->m_multiFetch && self->m_multiFetchLimit == 0) {
+		self->TuneMultiFetch(numRecords, offset);
+	}
+
+	return scope.Close(records);
+}
+
+/*
+ * Sets field of the control block or buffer (database ID and file number
+ * are passed back to be set together).
+ */
+const char*
+Command::SetFieldValue(int field, v8::Local<v8::Value> value,
+	unsigned short& dbId, unsigned short& fileNo)
+{
+	switch (field) {
+	case COMMAND_CODE:
+		return SetField(m_cb.cb_cmd_code, sizeof(m_cb.cb_cmd_code), value);
+	case COMMAND_ID:
+		return SetField(m_cb.cb_cmd_id, L_CID, value);
+	case DB_ID:
+		return SetField(dbId, value);
+	case FILE_NO:
+		return SetField(fileNo, value);
+	case RETURN_CODE:
+		if (CB_PHYS_FILE_NR(&m_cb)) {
+			return "return code used as database ID";
+		}
+		return SetField(m_cb.cb_return_code, value);
+	case ISN:
+		return SetField(m_cb.cb_isn, value);
+	case ISN_LOWER_LIMIT:
+		return SetField(m_cb.cb_isn_ll, value);
+	case ISN_QUANTITY:
+		return SetField(m_cb.cb_isn_quantity, value);
+	case FORMAT_BUFFER_LENGTH:
+		return SetField(m_cb.cb_fmt_buf_lng, value);
+	case RECORD_BUFFER_LENGTH:
+		return SetField(m_cb.cb_rec_buf_lng, value);
+	case SEARCH_BUFFER_LENGTH:
+		return SetField(m_cb.cb_sea_buf_lng, value);
+	case VALUE_BUFFER_LENGTH:
+		return SetField(m_cb.cb_val_buf_lng, value);
+	case ISN_BUFFER_LENGTH:
+		return SetField(m_cb.cb_isn_buf_lng, value);
+	case COMMAND_OPTION1:
+		return SetField(m_cb.cb_cop1, value);
+	case COMMAND_OPTION2:
+		return SetField(m_cb.cb_cop2, value);
+	case ADDITION1:
+		return SetFieldArray(m_cb.cb_add1, CB_L_AD1, value);
+	case ADDITION2:
+		return SetFieldArray(m_cb.cb_add2, CB_L_AD2, value);
+	case ADDITION3:
+		return SetFieldArray(m_cb.cb_add3, CB_L_AD3, value);
+	case ADDITION4:
+		return SetFieldArray(m_cb.cb_add4, CB_L_AD4, value);
+	case ADDITION5:
+		return SetFieldArray(m_cb.cb_add5, CB_L_AD5, value);
+	case COMMAND_TIME:
+		return SetField(m_cb.cb_cmd_time, value);
+	case USER_AREA:
+		return SetFieldArray(m_cb.cb_user_area,
+			sizeof(m_cb.cb_user_area), value);
+	case FORMAT_BUFFER:
+	case RECORD_BUFFER:
+	case SEARCH_BUFFER:
+	case VALUE_BUFFER:
+	case ISN_BUFFER:
+		return SetBufferField(this, field - FORMAT_BUFFER, value);
+	}
+	return NULL;
+}
+
+/*
+ * Returns field of the control block or buffer.
+ */
+v8::Local<v8::Value>
+Command::GetFieldValue(int field)
+{
+	switch (field) {
+	case COMMAND_CODE:
+		return GetField(m_cb.cb_cmd_code, sizeof(m_cb.cb_cmd_code));
+	case COMMAND_ID:
+		return GetField(m_cb.cb_cmd_id, L_CID);
+	case DB_ID:
+		if (CB_PHYS_FILE_NR(&m_cb)) {
+			return GetField(m_cb.alt_cb_db_id);
+		}
+		return GetField(m_cb.cb_db_id);
+	case FILE_NO:
+		if (CB_PHYS_FILE_NR(&m_cb)) {
+			return GetField(m_cb.alt_cb_file_nr);
+		}
+		return GetField(m_cb.cb_file_nr);
+	case RETURN_CODE:
+		return GetField(m_cb.cb_return_code);
+	case ISN:
+		return GetField(m_cb.cb_isn);
+	case ISN_LOWER_LIMIT:
+		return GetField(m_cb.cb_isn_ll);
+	case ISN_QUANTITY:
+		return GetField(m_cb.cb_isn_quantity);
+	case FORMAT_BUFFER_LENGTH:
+		return GetField(m_cb.cb_fmt_buf_lng);
+	case RECORD_BUFFER_LENGTH:
+		return GetField(m_cb.cb_rec_buf_lng);
+	case SEARCH_BUFFER_LENGTH:
+		return GetField(m_cb.cb_sea_buf_lng);
+	case VALUE_BUFFER_LENGTH:
+		return GetField(m_cb.cb_val_buf_lng);
+	case ISN_BUFFER_LENGTH:
+		return GetField(m_cb.cb_isn_buf_lng);
+	case COMMAND_OPTION1:
+		return GetField(m_cb.cb_cop1);
+	case COMMAND_OPTION2:
+		return GetField(m_cb.cb_cop2);
+	case ADDITION1:
+		return GetFieldArray(m_cb.cb_add1, CB_L_AD1);
+	case ADDITION2:
+		return GetFieldArray(m_cb.cb_add2, CB_L_AD2);
+	case ADDITION3:
+		return GetFieldArray(m_cb.cb_add3, CB_L_AD3);
+	case ADDITION4:
+		return GetFieldArray(m_cb.cb_add4, CB_L_AD4);
+	case ADDITION5:
+		return GetFieldArray(m_cb.cb_add5, CB_L_AD5);
+	case COMMAND_TIME:
+		return GetField(m_cb.cb_cmd_time);
+	case USER_AREA:
+		return GetFieldArray(m_cb.cb_user_area, sizeof(m_cb.cb_user_area));
+	case FORMAT_BUFFER:
+	case RECORD_BUFFER:
+	case SEARCH_BUFFER:
+	case VALUE_BUFFER:
+	case ISN_BUFFER:
+		return GetBuffer(field - FORMAT_BUFFER);
+	}
+	return v8::Local<v8::Value>::New(v8::Undefined());
+}
+
+/*
+ * Sets fields of the control block and buffers from the object by one
+ * call: set({ commandCode: 'L3', dbId: 88, fileNo: 12, ... }). Property
+ * names are names of setters without 'set', other properties are
+ * ignored.
+ */
+v8::Handle<v8::Value>
+Command::Set(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Command* self = ObjectWrap::Unwrap<Command>(args.This());
+
+	if (args.Length() != 1) {
+                return V8_ERROR("wrong number of arguments");
+	}
+	if (!args[0]->IsObject()) {
+                return V8_ERROR("argument must be an object");
+	}
+	v8::Local<v8::Object> fields = args[0]->ToObject();
+
+	unsigned short dbId = CB_PHYS_FILE_NR(&self->m_cb) ?
+		self->m_cb.alt_cb_db_id : self->m_cb.cb_db_id;
+	unsigned short fileNo = CB_PHYS_FILE_NR(&self->m_cb) ?
+		self->m_cb.alt_cb_file_nr : self->m_cb.cb_file_nr;
+	bool fileChanged = false;
+
+	/*
+	 * Command is changed only if all fields are valid: the control block
+	 * is restored on error, buffers are checked before any is set. Return
+	 * code is set after database ID and file number, because it holds
+	 * them for physical file numbers.
+	 */
+	CB_PAR saved = self->m_cb;
+	v8::Local<v8::Value> values[NUM_FIELDS];
+	const char* rc = NULL;
+	int failedField = 0;
+	for (int field = 0; field < NUM_FIELDS && rc == NULL; field++) {
+		values[field] = fields->Get(fieldSymbols[field]);
+		if (values[field]->IsUndefined() || field == RETURN_CODE) {
+			continue;
+		}
+		failedField = field;
+		if (field >= FORMAT_BUFFER) {
+			if (!node::Buffer::HasInstance(values[field])) {
+				rc = "argument must be a buffer";
+			}
+		} else {
+			rc = self->SetFieldValue(field, values[field], dbId, fileNo);
+		}
+		fileChanged = fileChanged || field == DB_ID || field == FILE_NO;
+	}
+
+	if (rc == NULL) {
+		if (fileChanged) {
+			CB_SET_FD(&self->m_cb, dbId, fileNo);
+		}
+		if (!values[RETURN_CODE]->IsUndefined()) {
+			failedField = RETURN_CODE;
+			rc = self->SetFieldValue(RETURN_CODE, values[RETURN_CODE],
+				dbId, fileNo);
+		}
+	}
+	if (rc != NULL) {
+		self->m_cb = saved;
+		std::string message = fieldNames[failedField][0];
+		message += ": ";
+		message += rc;
+		return V8_ERROR(message.c_str());
+	}
+
+	for (int field = FORMAT_BUFFER; field < NUM_FIELDS; field++) {
+		if (!values[field]->IsUndefined()) {
+			self->SetFieldValue(field, values[field], dbId, fileNo);
+		}
+	}
+
+	return scope.Close(args.This());
+}
+
+/*
+ * Returns object with fields of the control block and buffers by one
+ * call: get([mask]), where mask combines FIELD_* constants (all fields
+ * by default).
+ */
+v8::Handle<v8::Value>
+Command::Get(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	Command* self = ObjectWrap::Unwrap<Command>(args.This());
+
+	if (args.Length() > 1) {
+                return V8_ERROR("wrong number of arguments");
+	}
+
+	uint32_t mask = (1 << NUM_FIELDS) - 1;
+	if (args.Length() == 1) {
+		if (!args[0]->IsUint32()) {
+			return V8_ERROR("argument must be a mask of fields");
+		}
+		mask = args[0]->Uint32Value();
+	}
+
+	v8::Local<v8::Object> fields = v8::Object::New();
+	for (int field = 0; field < NUM_FIELDS; field++) {
+		// Return code holds database ID and file number of physical
+		// file numbers.
+		if (field == RETURN_CODE && CB_PHYS_FILE_NR(&self->m_cb)) {
+			continue;
+		}
+		if ((mask & (1 << field)) != 0) {
+			fields->Set(fieldSymbols[field], self->GetFieldValue(field));
+		}
+	}
+
+	return scope.Close(fields);
 }
 
 } // namespace node_adabas
@@ -12,6 +12,8 @@ extern "C" {
 #include <node.h>
 #include <vector>
 
+#include "buffer_pool.h"
+
 namespace node_adabas {
 
 /*
@@ -48,12 +50,17 @@ protected:
 		RECORD_BUFFER,
 		SEARCH_BUFFER,
 		VALUE_BUFFER,
-		ISN_BUFFER
+		ISN_BUFFER,
+
+		NUM_FIELDS
 	};
 
 private:
 	static v8::Persistent<v8::Function> constructor;
 
+	// Property names of the fields for set() and get().
+	static v8::Persistent<v8::String> fieldSymbols[NUM_FIELDS];
+
 public:
 	/*
 	 * Adabas direct call control block ('cb' is used in Adabas headers).
@@ -65,12 +72,49 @@ public:
 	 */
 	void *m_buffers[5];
 
+	/*
+	 * Buffer objects of the direct call buffers (command keeps them
+	 * alive while it refers to their data).
+	 */
+	v8::Persistent<v8::Object> m_bufferObjects[5];
+
+	/*
+	 * Pool of the Adabas instance, which owns the command (NULL - none);
+	 * clone() takes new buffers from it.
+	 */
+	BufferPool* m_bufferPool;
+
+	/*
+	 * Session of the Adabas instance (-1 - command has no session).
+	 */
+	int m_session;
+
+	/*
+	 * Duration of the last Adabas call of the command (nanoseconds).
+	 */
+	uint64_t m_lastCallTime;
+
+	/*
+	 * Multi-fetch mode: maximal number of records per call (0 - number
+	 * of records is tuned by the size of records and the call time),
+	 * target duration of the call (microseconds, 0 - not limited) and
+	 * average record length observed.
+	 */
+	bool m_multiFetch;
+	uint32_t m_multiFetchLimit;
+	uint64_t m_multiFetchTargetTime;
+	double m_multiFetchRecordLength;
+
 private:
 	Command();
+	~Command();
 
 	static v8::Handle<v8::Value> New(const v8::Arguments& args);
 	static v8::Handle<v8::Value> Clear(const v8::Arguments& args);
 	static v8::Handle<v8::Value> ToString(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Clone(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Set(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Get(const v8::Arguments& args);
 
 	static v8::Handle<v8::Value>
 		SetCommandCode(const v8::Arguments& args);
@@ -126,6 +170,10 @@ private:
 		SetValueBuffer(const v8::Arguments& args);
 	static v8::Handle<v8::Value>
 		SetIsnBuffer(const v8::Arguments& args);
+	static v8::Handle<v8::Value>
+		SetSession(const v8::Arguments& args);
+	static v8::Handle<v8::Value>
+		SetMultiFetch(const v8::Arguments& args);
 
 	static v8::Handle<v8::Value>
 		GetCommandCode(const v8::Arguments& args);
@@ -181,10 +229,30 @@ private:
 		GetValueBuffer(const v8::Arguments& args);
 	static v8::Handle<v8::Value>
 		GetIsnBuffer(const v8::Arguments& args);
+	static v8::Handle<v8::Value>
+		GetSession(const v8::Arguments& args);
+	static v8::Handle<v8::Value>
+		GetMultiFetch(const v8::Arguments& args);
+	static v8::Handle<v8::Value>
+		GetControlBlock(const v8::Arguments& args);
+
+	void TuneMultiFetch(uint32_t numRecords, size_t recordsLength);
+	const char* SetFieldValue(int field, v8::Local<v8::Value> value,
+		unsigned short& dbId, unsigned short& fileNo);
+	v8::Local<v8::Value> GetFieldValue(int field);
 
 public:
+	void SetBuffer(unsigned int index, v8::Handle<v8::Object> buffer);
+	v8::Local<v8::Value> GetBuffer(unsigned int index);
+	void SetBufferLength(unsigned int index, unsigned short length);
+	unsigned short GetBufferLength(unsigned int index) const;
+	void SetBufferPool(BufferPool* pool);
+
 	static void Initialize(v8::Handle<v8::Object> exports);
 	static v8::Handle<v8::Value> NewInstance(const v8::Arguments& args);
+	static Command* FromValue(v8::Handle<v8::Value> value);
+	static v8::Local<v8::Object> NewIsnArray(v8::Handle<v8::Object> buffer,
+		uint32_t numIsns);
 };
 
 } // namespace node_adabas
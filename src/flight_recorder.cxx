@@ -0,0 +1,265 @@
+#include <sstream>
+#include <string.h>
+
+#include "atomic.h"
+#include "flight_recorder.h"
+
+namespace node_adabas {
+
+// Maximal number of attempts to copy the slot, which is being written.
+#define MAX_COPY_ATTEMPTS 16
+
+// Names of buffers in the slow log.
+static const char* bufferNames[FlightRecorder::NUM_BUFFERS] = {
+	"format", "record", "search", "value", "isn"
+};
+
+/*
+ * Constructor.
+ */
+FlightRecorder::FlightRecorder() :
+	m_threadNo(-1),
+	m_numCalls(0),
+	m_numSlowCalls(0),
+	m_slowThreshold(0),
+	m_slowBytes(0)
+{
+}
+
+void
+FlightRecorder::Init(int threadNo, uint32_t numCalls, uint32_t numSlowCalls,
+	uint64_t slowThreshold, uint32_t slowBytes)
+{
+	m_threadNo = threadNo;
+	m_calls.resize(numCalls);
+	m_callSequences.resize(numCalls, 0);
+
+	if (slowThreshold > 0 && numSlowCalls > 0) {
+		m_slowThreshold = slowThreshold;
+		m_slowBytes = slowBytes > MAX_SLOW_BYTES ? MAX_SLOW_BYTES : slowBytes;
+		m_slowCalls.resize(numSlowCalls);
+		m_slowSequences.resize(numSlowCalls, 0);
+		m_slowLengths.resize(numSlowCalls * NUM_BUFFERS, 0);
+		m_slowData.resize(numSlowCalls * NUM_BUFFERS * m_slowBytes);
+	}
+}
+
+/*
+ * Returns length of the buffer in the control block.
+ */
+static uint32_t
+BufferLength(const CB_PAR& cb, unsigned int buffer)
+{
+	switch (buffer) {
+	case 0:
+		return cb.cb_fmt_buf_lng;
+	case 1:
+		return cb.cb_rec_buf_lng;
+	case 2:
+		return cb.cb_sea_buf_lng;
+	case 3:
+		return cb.cb_val_buf_lng;
+	default:
+		return cb.cb_isn_buf_lng;
+	}
+}
+
+void
+FlightRecorder::Record(const CB_PAR& cb, void* const* buffers, int rc,
+	uint64_t time, uint64_t duration)
+{
+	if (!m_calls.empty()) {
+		uint32_t index = m_numCalls % m_calls.size();
+		volatile uint32_t* sequence =
+			(volatile uint32_t*) &m_callSequences[index];
+		uint32_t value = *sequence;
+		AtomicStore(sequence, value + 1);
+		AtomicFence();
+
+		Call& call = m_calls[index];
+		call.time = time;
+		call.duration = duration;
+		call.rc = rc;
+		call.threadNo = m_threadNo;
+		memcpy(&call.cb, &cb, sizeof(CB_PAR));
+
+		AtomicStore(sequence, value + 2);
+		AtomicStore(&m_numCalls, m_numCalls + 1);
+	}
+
+	if (m_slowThreshold == 0 || duration < m_slowThreshold) {
+		return;
+	}
+
+	uint32_t index = m_numSlowCalls % m_slowCalls.size();
+	volatile uint32_t* sequence =
+		(volatile uint32_t*) &m_slowSequences[index];
+	uint32_t value = *sequence;
+	AtomicStore(sequence, value + 1);
+	AtomicFence();
+
+	Call& call = m_slowCalls[index];
+	call.time = time;
+	call.duration = duration;
+	call.rc = rc;
+	call.threadNo = m_threadNo;
+	memcpy(&call.cb, &cb, sizeof(CB_PAR));
+
+	for (unsigned int buffer = 0; buffer < NUM_BUFFERS; buffer++) {
+		uint32_t length = buffers[buffer] == NULL ? 0 :
+			BufferLength(cb, buffer);
+		if (length > m_slowBytes) {
+			length = m_slowBytes;
+		}
+		if (length > 0) {
+			size_t offset = (index * NUM_BUFFERS + buffer) * m_slowBytes;
+			memcpy(&m_slowData[offset], buffers[buffer], length);
+		}
+		m_slowLengths[index * NUM_BUFFERS + buffer] = length;
+	}
+
+	AtomicStore(sequence, value + 2);
+	AtomicStore(&m_numSlowCalls, m_numSlowCalls + 1);
+}
+
+void
+FlightRecorder::Collect(std::vector<Call>& calls) const
+{
+	uint32_t numCalls = AtomicLoad(&m_numCalls);
+	if (numCalls > m_calls.size()) {
+		numCalls = uint32_t(m_calls.size());
+	}
+
+	// Slots are copied in any order, caller sorts calls by time.
+	for (uint32_t index = 0; index < numCalls; index++) {
+		const volatile uint32_t* sequence =
+			(const volatile uint32_t*) &m_callSequences[index];
+		for (int attempt = 0; attempt < MAX_COPY_ATTEMPTS; attempt++) {
+			uint32_t value = AtomicLoad(sequence);
+			if (value & 1) {
+				continue;
+			}
+			Call call = m_calls[index];
+			AtomicFence();
+			if (*sequence == value) {
+				calls.push_back(call);
+				break;
+			}
+		}
+	}
+}
+
+void
+FlightRecorder::CollectSlow(std::vector<SlowCall>& slowCalls) const
+{
+	uint32_t numSlowCalls = AtomicLoad(&m_numSlowCalls);
+	if (numSlowCalls > m_slowCalls.size()) {
+		numSlowCalls = uint32_t(m_slowCalls.size());
+	}
+
+	for (uint32_t index = 0; index < numSlowCalls; index++) {
+		const volatile uint32_t* sequence =
+			(const volatile uint32_t*) &m_slowSequences[index];
+		for (int attempt = 0; attempt < MAX_COPY_ATTEMPTS; attempt++) {
+			uint32_t value = AtomicLoad(sequence);
+			if (value & 1) {
+				continue;
+			}
+			SlowCall slowCall;
+			slowCall.call = m_slowCalls[index];
+			for (unsigned int buffer = 0; buffer < NUM_BUFFERS; buffer++) {
+				uint32_t length = m_slowLengths[index * NUM_BUFFERS + buffer];
+				if (length > 0) {
+					size_t offset =
+						(index * NUM_BUFFERS + buffer) * m_slowBytes;
+					slowCall.buffers[buffer].assign(&m_slowData[offset],
+						length);
+				}
+			}
+			AtomicFence();
+			if (*sequence == value) {
+				slowCalls.push_back(slowCall);
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * Writes bytes in hex.
+ */
+static void
+WriteHex(std::ostringstream& out, const unsigned char* data, size_t length)
+{
+	static const char digits[] = "0123456789abcdef";
+	for (size_t i = 0; i < length; i++) {
+		out << digits[data[i] >> 4] << digits[data[i] & 0x0F];
+	}
+}
+
+std::string
+FlightRecorder::Format(const Call& call, uint64_t now)
+{
+	const CB_PAR& cb = call.cb;
+	bool physical = CB_PHYS_FILE_NR(&cb);
+
+	std::ostringstream out;
+	out.setf(std::ios::fixed);
+	out.precision(3);
+
+	if (call.threadNo < 0) {
+		out << "[main] ";
+	} else {
+		out << "[thread " << call.threadNo << "] ";
+	}
+	out << "-" << double(now - call.time) / 1000000 << "ms ";
+
+	for (int i = 0; i < 2; i++) {
+		unsigned char c = cb.cb_cmd_code[i];
+		out << (c >= 0x20 && c < 0x7F ? char(c) : '?');
+	}
+	out << " cid=";
+	WriteHex(out, reinterpret_cast<const unsigned char*>(cb.cb_cmd_id),
+		sizeof(cb.cb_cmd_id));
+	out << " db=" << (physical ? cb.alt_cb_db_id : cb.cb_db_id)
+		<< " file=" << (physical ? cb.alt_cb_file_nr : cb.cb_file_nr)
+		<< " rsp=" << cb.cb_return_code
+		<< " isn=" << cb.cb_isn
+		<< " isnll=" << cb.cb_isn_ll
+		<< " isnq=" << cb.cb_isn_quantity
+		<< " fbl=" << cb.cb_fmt_buf_lng
+		<< " rbl=" << cb.cb_rec_buf_lng
+		<< " sbl=" << cb.cb_sea_buf_lng
+		<< " vbl=" << cb.cb_val_buf_lng
+		<< " ibl=" << cb.cb_isn_buf_lng
+		<< " cop=";
+	WriteHex(out, reinterpret_cast<const unsigned char*>(&cb.cb_cop1), 1);
+	WriteHex(out, reinterpret_cast<const unsigned char*>(&cb.cb_cop2), 1);
+	out << " add1=";
+	WriteHex(out, reinterpret_cast<const unsigned char*>(cb.cb_add1),
+		sizeof(cb.cb_add1));
+	out << " cmdtime=" << cb.cb_cmd_time
+		<< " duration=" << double(call.duration) / 1000 << "us"
+		<< " rc=" << call.rc;
+
+	return out.str();
+}
+
+std::string
+FlightRecorder::FormatSlow(const SlowCall& slowCall, uint64_t now)
+{
+	std::ostringstream out;
+	out << Format(slowCall.call, now);
+	for (unsigned int buffer = 0; buffer < NUM_BUFFERS; buffer++) {
+		const std::string& data = slowCall.buffers[buffer];
+		if (data.empty()) {
+			continue;
+		}
+		out << "\n  " << bufferNames[buffer] << ": ";
+		WriteHex(out, reinterpret_cast<const unsigned char*>(data.data()),
+			data.size());
+	}
+	return out.str();
+}
+
+} // namespace node_adabas
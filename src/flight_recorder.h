@@ -0,0 +1,108 @@
+#ifndef NODE_ADABAS_SRC_FLIGHT_RECORDER_H
+#define NODE_ADABAS_SRC_FLIGHT_RECORDER_H
+
+#ifndef CE_VOID
+#define CE_VOID void
+#endif // CE_VOID
+
+extern "C" {
+#include <adabasx.h>
+}
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace node_adabas {
+
+/*
+ * Flight recorder of Adabas calls of one thread: ring of snapshots of the
+ * last calls and ring of slow calls with the first bytes of their
+ * buffers. Recorder is written by its thread only and read by main
+ * thread, each slot is guarded by sequence number (odd while the slot is
+ * written). Memory is allocated by Init(), recording doesn't allocate.
+ */
+class FlightRecorder {
+public:
+	// Number of Adabas buffers (format, record, search, value, ISN).
+	static const unsigned int NUM_BUFFERS = 5;
+	// Maximal number of bytes of the buffer copied to the slow log.
+	static const unsigned int MAX_SLOW_BYTES = 4096;
+
+	/*
+	 * Snapshot of the call: control block after the call, start time
+	 * (uv_hrtime()) and duration in nanoseconds, result code and number
+	 * of the thread (-1 - main thread).
+	 */
+	struct Call {
+		uint64_t time;
+		uint64_t duration;
+		int rc;
+		int threadNo;
+		CB_PAR cb;
+	};
+
+	/*
+	 * Slow call with the first bytes of its buffers.
+	 */
+	struct SlowCall {
+		Call call;
+		std::string buffers[NUM_BUFFERS];
+	};
+
+private:
+	int m_threadNo;
+	// Ring of calls and sequence numbers of its slots.
+	std::vector<Call> m_calls;
+	std::vector<uint32_t> m_callSequences;
+	volatile uint32_t m_numCalls;
+	// Ring of slow calls, lengths and copied bytes of their buffers.
+	std::vector<Call> m_slowCalls;
+	std::vector<uint32_t> m_slowSequences;
+	std::vector<uint32_t> m_slowLengths;
+	std::vector<char> m_slowData;
+	volatile uint32_t m_numSlowCalls;
+	// Calls longer than threshold (nanoseconds, 0 - none) are slow.
+	uint64_t m_slowThreshold;
+	uint32_t m_slowBytes;
+
+public:
+	FlightRecorder();
+
+	/*
+	 * Allocates rings: number of calls, number of slow calls, slow call
+	 * threshold in nanoseconds and number of bytes copied from each
+	 * buffer of the slow call.
+	 */
+	void Init(int threadNo, uint32_t numCalls, uint32_t numSlowCalls,
+		uint64_t slowThreshold, uint32_t slowBytes);
+
+	bool Enabled(void) const
+	{
+		return !m_calls.empty() || m_slowThreshold > 0;
+	}
+
+	/*
+	 * Records the call (in thread of the recorder).
+	 */
+	void Record(const CB_PAR& cb, void* const* buffers, int rc,
+		uint64_t time, uint64_t duration);
+
+	/*
+	 * Adds recorded calls and slow calls to the vectors (in main
+	 * thread).
+	 */
+	void Collect(std::vector<Call>& calls) const;
+	void CollectSlow(std::vector<SlowCall>& slowCalls) const;
+
+	/*
+	 * Formats the call as a line of text; time is shown relative to
+	 * 'now' (uv_hrtime()).
+	 */
+	static std::string Format(const Call& call, uint64_t now);
+	static std::string FormatSlow(const SlowCall& slowCall, uint64_t now);
+};
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_FLIGHT_RECORDER_H
@@ -0,0 +1,844 @@
+#include <cctype>
+#include <cstring>
+#include <node.h>
+#include <node_buffer.h>
+#include <sstream>
+
+#include "codec.h"
+#include "command.h"
+#include "format_buffer.h"
+#include "transcode.h"
+#include "v8_helpers.h"
+
+// Maximal number of cached compiled format buffers.
+#define FORMAT_CACHE_SIZE 256
+
+namespace node_adabas {
+
+v8::Persistent<v8::Function> FormatBuffer::constructor;
+std::map<std::string, v8::Persistent<v8::Object> > FormatBuffer::cache;
+
+/*
+ * Constructor.
+ */
+FormatBuffer::FormatBuffer() :
+	ObjectWrap(),
+	m_codePage(transcode::LATIN1),
+	m_recordLength(0),
+	m_variableLength(false)
+{
+}
+
+/*
+ * Destructor.
+ */
+FormatBuffer::~FormatBuffer()
+{
+	for (size_t i = 0; i < m_names.size(); i++) {
+		m_names[i].Dispose();
+	}
+	m_template.Dispose();
+}
+
+/*
+ * Initializes the Node.js class.
+ */
+void
+FormatBuffer::Initialize(v8::Handle<v8::Object> exports)
+{
+	// Prepare constructor template.
+	v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New(New);
+	t->SetClassName(v8::String::NewSymbol("FormatBuffer"));
+	t->InstanceTemplate()->SetInternalFieldCount(1);
+
+	// Prototype.
+	V8_METHOD("decode", Decode);
+	V8_METHOD("decodeMany", DecodeMany);
+	V8_METHOD("encode", Encode);
+	V8_METHOD("getRecordLength", GetRecordLength);
+	V8_METHOD("toString", ToString);
+
+	constructor = v8::Persistent<v8::Function>::New(t->GetFunction());
+	exports->Set(v8::String::NewSymbol("FormatBuffer"), constructor);
+	exports->Set(v8::String::NewSymbol("compileFormat"),
+		v8::FunctionTemplate::New(CompileFormat)->GetFunction());
+	exports->Set(v8::String::NewSymbol("simdLevel"),
+		v8::String::New(codec::SimdLevel()));
+}
+
+/*
+ * Parses unsigned number.
+ */
+static bool
+ParseNumber(const std::string& s, size_t begin, size_t end,
+	uint32_t& number)
+{
+	if (begin >= end || end - begin > 5) {
+		return false;
+	}
+	number = 0;
+	for (size_t i = begin; i < end; i++) {
+		if (!isdigit(s[i])) {
+			return false;
+		}
+		number = number * 10 + (s[i] - '0');
+	}
+	return true;
+}
+
+/*
+ * Checks length of the field of the format.
+ */
+static bool
+IsValidLength(char format, uint32_t length)
+{
+	switch (format) {
+	case 'A':
+		return length <= 253;
+	case 'B':
+		return length <= 126;
+	case 'F':
+		return length == 1 || length == 2 || length == 4 || length == 8;
+	case 'G':
+		return length == 4 || length == 8;
+	case 'P':
+		return length >= 1 && length <= 15;
+	case 'U':
+		return length >= 1 && length <= 29;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Parses format buffer into the table of fields. Supported elements:
+ * 'name,length,format' (name may have range of occurrences 'AA1-5',
+ * length 0 - variable length) and 'nX' (skip n bytes).
+ */
+const char*
+FormatBuffer::Parse(const std::string& format, std::vector<Field>& fields)
+{
+	// Split format buffer into elements.
+	std::vector<std::string> elements;
+	std::string element;
+	bool terminated = false;
+	for (size_t i = 0; i < format.size(); i++) {
+		char c = format[i];
+		if (isspace(c)) {
+			continue;
+		}
+		if (terminated) {
+			return "text after the end of the format buffer";
+		}
+		if (c == ',' || c == '.') {
+			elements.push_back(element);
+			element.clear();
+			terminated = c == '.';
+		} else {
+			element += toupper(c);
+		}
+	}
+	if (!terminated) {
+		elements.push_back(element);
+	}
+
+	fields.clear();
+	for (size_t i = 0; i < elements.size(); i++) {
+		const std::string& e = elements[i];
+		if (e.empty()) {
+			return "empty element of the format buffer";
+		}
+
+		// Skipped bytes.
+		if (isdigit(e[0])) {
+			Field field;
+			field.format = 'X';
+			if (e[e.size() - 1] != 'X' ||
+				!ParseNumber(e, 0, e.size() - 1, field.length) ||
+				field.length == 0)
+			{
+				return "invalid element of the format buffer";
+			}
+			fields.push_back(field);
+			continue;
+		}
+
+		if (!isalpha(e[0])) {
+			return "invalid field name in the format buffer";
+		}
+
+		// Field name with optional range of occurrences.
+		std::string name = e;
+		uint32_t first = 0;
+		uint32_t last = 0;
+		size_t dash = e.find('-');
+		if (dash != std::string::npos) {
+			size_t begin = dash;
+			while (begin > 0 && isdigit(e[begin - 1])) {
+				begin--;
+			}
+			if (begin < 2 || !ParseNumber(e, begin, dash, first) ||
+				!ParseNumber(e, dash + 1, e.size(), last) ||
+				first == 0 || first > last)
+			{
+				return "invalid range of occurrences in the format buffer";
+			}
+			name = e.substr(0, begin);
+		}
+
+		if (i + 2 >= elements.size()) {
+			return "length and format of the field must be specified";
+		}
+
+		uint32_t length;
+		const std::string& formatElement = elements[i + 2];
+		if (!ParseNumber(elements[i + 1], 0, elements[i + 1].size(),
+			length) || formatElement.size() != 1 ||
+			!IsValidLength(formatElement[0], length))
+		{
+			return "invalid length or format of the field";
+		}
+		i += 2;
+
+		Field field;
+		field.format = formatElement[0];
+		field.length = length;
+		if (dash == std::string::npos) {
+			field.name = name;
+			fields.push_back(field);
+		} else {
+			for (uint32_t occurrence = first; occurrence <= last;
+				occurrence++)
+			{
+				std::ostringstream s;
+				s << name << occurrence;
+				field.name = s.str();
+				fields.push_back(field);
+			}
+		}
+	}
+
+	if (fields.empty()) {
+		return "format buffer is empty";
+	}
+
+	return NULL;
+}
+
+/*
+ * Compiles format buffer: table of fields and template of records.
+ */
+const char*
+FormatBuffer::Compile(const std::string& format)
+{
+	const char* rc = Parse(format, m_fields);
+	if (rc != NULL) {
+		return rc;
+	}
+	m_format = format;
+
+	v8::Local<v8::ObjectTemplate> recordTemplate =
+		v8::ObjectTemplate::New();
+	m_names.resize(m_fields.size());
+	m_columns.resize(m_fields.size());
+	m_recordLength = 0;
+	m_variableLength = false;
+	for (size_t i = 0; i < m_fields.size(); i++) {
+		const Field& field = m_fields[i];
+		m_recordLength += field.length == 0 ? 1 : field.length;
+		m_variableLength = m_variableLength || field.length == 0;
+		m_columns[i] =
+			(field.format == 'P' &&
+				field.length <= codec::MAX_PACKED_COLUMN_LENGTH) ||
+			(field.format == 'U' &&
+				field.length <= codec::MAX_UNPACKED_COLUMN_LENGTH);
+		if (field.format == 'X') {
+			continue;
+		}
+		m_names[i] = v8::Persistent<v8::String>::New(
+			v8::String::NewSymbol(field.name.c_str()));
+		recordTemplate->Set(m_names[i], v8::Null());
+	}
+	m_template = v8::Persistent<v8::ObjectTemplate>::New(recordTemplate);
+
+	return NULL;
+}
+
+/*
+ * Creates new instance of the object: new FormatBuffer(format
+ * [, codePage]). Code page of alphanumeric fields is 'latin1' (default),
+ * 'cp037', 'cp500' or 'cp1047'.
+ */
+v8::Handle<v8::Value>
+FormatBuffer::New(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+
+	if (!args.IsConstructCall()) {
+		v8::Local<v8::Value> argv[] = { args[0], args[1] };
+		return scope.Close(constructor->NewInstance(args.Length(), argv));
+	}
+
+	unsigned int numArgs = args.Length();
+	if (numArgs < 1 || numArgs > 2) {
+		return V8_ERROR("wrong number of arguments");
+	}
+	if (!args[0]->IsString()) {
+		return V8_ERROR("first argument must be a format buffer string");
+	}
+
+	transcode::CodePage codePage = transcode::LATIN1;
+	if (numArgs == 2 && !transcode::FindCodePage(
+		*v8::String::Utf8Value(args[1]), codePage))
+	{
+		return V8_ERROR("unknown code page");
+	}
+
+	FormatBuffer* self = new FormatBuffer();
+	self->m_codePage = codePage;
+	const char* rc = self->Compile(*v8::String::Utf8Value(args[0]));
+	if (rc != NULL) {
+		delete self;
+		return V8_ERROR(rc);
+	}
+
+	self->Wrap(args.This());
+	return args.This();
+}
+
+/*
+ * Returns compiled format buffer from the cache or compiles it:
+ * compileFormat(format[, codePage]).
+ */
+v8::Handle<v8::Value>
+FormatBuffer::CompileFormat(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+
+	unsigned int numArgs = args.Length();
+	if (numArgs < 1 || numArgs > 2) {
+		return V8_ERROR("wrong number of arguments");
+	}
+	if (!args[0]->IsString()) {
+		return V8_ERROR("first argument must be a format buffer string");
+	}
+
+	// Key of the cache includes the code page.
+	std::string format = *v8::String::Utf8Value(args[0]);
+	if (numArgs == 2) {
+		format += '/';
+		format += *v8::String::Utf8Value(args[1]);
+	}
+	std::map<std::string, v8::Persistent<v8::Object> >::iterator it =
+		cache.find(format);
+	if (it != cache.end()) {
+		return scope.Close(it->second);
+	}
+
+	v8::Local<v8::Value> argv[] = { args[0], args[1] };
+	v8::TryCatch try_catch;
+	v8::Local<v8::Object> formatBuffer =
+		constructor->NewInstance(numArgs, argv);
+	if (try_catch.HasCaught()) {
+		return try_catch.ReThrow();
+	}
+
+	if (cache.size() >= FORMAT_CACHE_SIZE) {
+		for (it = cache.begin(); it != cache.end(); ++it) {
+			it->second.Dispose();
+		}
+		cache.clear();
+	}
+	cache[format] = v8::Persistent<v8::Object>::New(formatBuffer);
+
+	return scope.Close(formatBuffer);
+}
+
+/*
+ * Converts decoded decimal into the number, if it is exact, or into the
+ * string of digits otherwise.
+ */
+static v8::Local<v8::Value>
+DecimalToValue(bool exact, int64_t value, char format,
+	const unsigned char* data, uint32_t length)
+{
+	if (exact && value <= codec::MAX_EXACT_DOUBLE &&
+		value >= -codec::MAX_EXACT_DOUBLE)
+	{
+		return v8::Number::New(double(value));
+	}
+	std::string digits = format == 'P' ?
+		codec::PackedToString(data, length) :
+		codec::UnpackedToString(data, length);
+	return v8::String::New(digits.c_str(), digits.size());
+}
+
+/*
+ * Decodes value of the field.
+ */
+static v8::Local<v8::Value>
+DecodeValue(char format, const unsigned char* data, uint32_t length,
+	transcode::CodePage codePage)
+{
+	switch (format) {
+	case 'A': {
+		// Trailing blanks are removed.
+		unsigned char blank = transcode::Blank(codePage);
+		while (length > 0 && data[length - 1] == blank) {
+			length--;
+		}
+		return transcode::NewString(codePage, data, length);
+	}
+
+	case 'B':
+		if (length == 1 || length == 2 || length == 4) {
+			return v8::Integer::NewFromUnsigned(
+				uint32_t(codec::DecodeBinary(data, length)));
+		}
+		return v8::Local<v8::Object>::New(
+			node::Buffer::New((const char*) data, length)->handle_);
+
+	case 'F':
+		if (length == 8) {
+			return v8::Number::New(double(codec::DecodeFixed(data, length)));
+		}
+		return v8::Integer::New(int32_t(codec::DecodeFixed(data, length)));
+
+	case 'G':
+		return v8::Number::New(codec::DecodeFloat(data, length));
+
+	case 'P': {
+		int64_t value;
+		bool exact = codec::DecodePacked(data, length, value);
+		return DecimalToValue(exact, value, format, data, length);
+	}
+
+	case 'U': {
+		int64_t value;
+		bool exact = codec::DecodeUnpacked(data, length, value);
+		return DecimalToValue(exact, value, format, data, length);
+	}
+	}
+
+	return v8::Local<v8::Value>::New(v8::Undefined());
+}
+
+/*
+ * Decodes record into the object. Values of the fields decoded by column
+ * kernels are passed in 'columnValues' (NULL - no column values).
+ */
+const char*
+FormatBuffer::DecodeRecord(const unsigned char* data, size_t remaining,
+	const double* columnValues, v8::Local<v8::Object>& record)
+{
+	if (remaining < m_recordLength) {
+		return "buffer is shorter than the record";
+	}
+
+	record = m_template->NewInstance();
+	for (size_t i = 0; i < m_fields.size(); i++) {
+		const Field& field = m_fields[i];
+
+		const unsigned char* value = data;
+		uint32_t length = field.length;
+		size_t fieldLength = length;
+		if (length == 0) {
+			// Variable length field, length byte includes itself.
+			if (remaining < 1 || data[0] < 1 || data[0] > remaining) {
+				return "invalid length of the field";
+			}
+			fieldLength = data[0];
+			value = data + 1;
+			length = data[0] - 1;
+		} else if (fieldLength > remaining) {
+			return "buffer is shorter than the record";
+		}
+
+		if (columnValues != NULL && m_columns[i]) {
+			record->Set(m_names[i], v8::Number::New(columnValues[i]));
+		} else if (field.format != 'X') {
+			record->Set(m_names[i],
+				DecodeValue(field.format, value, length, m_codePage));
+		}
+
+		data += fieldLength;
+		remaining -= fieldLength;
+	}
+
+	return NULL;
+}
+
+/*
+ * Decodes record buffer into the object: decode(buffer[, offset]).
+ */
+v8::Handle<v8::Value>
+FormatBuffer::Decode(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	FormatBuffer* self = ObjectWrap::Unwrap<FormatBuffer>(args.This());
+
+	unsigned int numArgs = args.Length();
+	if (numArgs < 1 || numArgs > 2) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	if (!node::Buffer::HasInstance(args[0])) {
+		return V8_ERROR("first argument must be a buffer");
+	}
+	v8::Local<v8::Object> buffer = args[0]->ToObject();
+	const unsigned char* data =
+		(const unsigned char*) node::Buffer::Data(buffer);
+	size_t remaining = node::Buffer::Length(buffer);
+
+	if (numArgs == 2) {
+		if (!args[1]->IsUint32() || args[1]->Uint32Value() > remaining) {
+			return V8_ERROR("invalid offset in the buffer");
+		}
+		data += args[1]->Uint32Value();
+		remaining -= args[1]->Uint32Value();
+	}
+
+	v8::Local<v8::Object> record;
+	const char* rc = self->DecodeRecord(data, remaining, NULL, record);
+	if (rc != NULL) {
+		return V8_ERROR(rc);
+	}
+
+	return scope.Close(record);
+}
+
+/*
+ * Decodes records located one after another into the array of objects:
+ * decodeMany(buffer, count[, offset]). Records must have fixed length,
+ * decimal fields are decoded by column kernels.
+ */
+v8::Handle<v8::Value>
+FormatBuffer::DecodeMany(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	FormatBuffer* self = ObjectWrap::Unwrap<FormatBuffer>(args.This());
+
+	unsigned int numArgs = args.Length();
+	if (numArgs < 2 || numArgs > 3) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	if (!node::Buffer::HasInstance(args[0])) {
+		return V8_ERROR("first argument must be a buffer");
+	}
+	v8::Local<v8::Object> buffer = args[0]->ToObject();
+	const unsigned char* data =
+		(const unsigned char*) node::Buffer::Data(buffer);
+	size_t remaining = node::Buffer::Length(buffer);
+
+	if (!args[1]->IsUint32()) {
+		return V8_ERROR("second argument must be a number of records");
+	}
+	uint32_t count = args[1]->Uint32Value();
+
+	if (numArgs == 3) {
+		if (!args[2]->IsUint32() || args[2]->Uint32Value() > remaining) {
+			return V8_ERROR("invalid offset in the buffer");
+		}
+		data += args[2]->Uint32Value();
+		remaining -= args[2]->Uint32Value();
+	}
+
+	if (self->m_variableLength) {
+		return V8_ERROR("records must have fixed length");
+	}
+	size_t recordLength = self->m_recordLength;
+	if (remaining / recordLength < count) {
+		return V8_ERROR("buffer is shorter than the records");
+	}
+	if (count == 0) {
+		return scope.Close(v8::Array::New(0));
+	}
+
+	// Decimal fields are decoded by columns, values are stored by
+	// records: columnValues[record * numFields + field].
+	size_t numFields = self->m_fields.size();
+	std::vector<double> columnValues(numFields * count);
+	std::vector<double> values(count);
+	size_t offset = 0;
+	for (size_t i = 0; i < numFields; i++) {
+		const Field& field = self->m_fields[i];
+		if (self->m_columns[i]) {
+			if (field.format == 'P') {
+				codec::DecodePackedColumn(data + offset, recordLength,
+					field.length, count, &values[0]);
+			} else {
+				codec::DecodeUnpackedColumn(data + offset, recordLength,
+					field.length, count, &values[0]);
+			}
+			for (uint32_t j = 0; j < count; j++) {
+				columnValues[j * numFields + i] = values[j];
+			}
+		}
+		offset += field.length;
+	}
+
+	v8::Local<v8::Array> records = v8::Array::New(count);
+	for (uint32_t j = 0; j < count; j++) {
+		v8::Local<v8::Object> record;
+		const char* rc = self->DecodeRecord(data + j * recordLength,
+			recordLength, &columnValues[j * numFields], record);
+		if (rc != NULL) {
+			return V8_ERROR(rc);
+		}
+		records->Set(j, record);
+	}
+
+	return scope.Close(records);
+}
+
+/*
+ * Encodes decimal from the number or the string of digits.
+ */
+static const char*
+EncodeDecimal(char format, v8::Local<v8::Value> value, bool missing,
+	unsigned char* data, uint32_t length)
+{
+	if (!missing && value->IsString()) {
+		std::string digits = *v8::String::Utf8Value(value);
+		return format == 'P' ?
+			codec::EncodePacked(digits, data, length) :
+			codec::EncodeUnpacked(digits, data, length);
+	}
+
+	double number = missing ? 0 : value->NumberValue();
+	if (number != number || number > codec::MAX_EXACT_DOUBLE ||
+		number < -codec::MAX_EXACT_DOUBLE)
+	{
+		return "value must be an exact number or a string of digits";
+	}
+	int64_t integer = int64_t(number < 0 ? number - 0.5 : number + 0.5);
+	return format == 'P' ?
+		codec::EncodePacked(integer, data, length) :
+		codec::EncodeUnpacked(integer, data, length);
+}
+
+/*
+ * Encodes value of the field into the record buffer (missing value is
+ * encoded as blanks or zero). Returns number of bytes written in
+ * 'written'.
+ */
+static const char*
+EncodeValue(const FormatBuffer::Field& field, v8::Local<v8::Value> value,
+	transcode::CodePage codePage, unsigned char* data, size_t remaining,
+	size_t& written)
+{
+	bool missing = value->IsUndefined() || value->IsNull();
+	uint32_t length = field.length;
+
+	// Alphanumeric and binary fields of variable length.
+	if (length == 0) {
+		if (field.format == 'A') {
+			if (remaining < 1) {
+				return "buffer is shorter than the record";
+			}
+			size_t stringLength = 0;
+			if (!missing) {
+				size_t capacity = remaining - 1 < 253 ? remaining - 1 : 253;
+				const char* rc = transcode::WriteString(codePage, value,
+					data + 1, capacity, stringLength);
+				if (rc != NULL) {
+					return rc;
+				}
+			}
+			length = uint32_t(stringLength);
+		} else {
+			if (!missing && !node::Buffer::HasInstance(value)) {
+				return "value of the binary field must be a buffer";
+			}
+			length = missing ? 0 : node::Buffer::Length(value->ToObject());
+			if (length > 126 || length + 1 > remaining) {
+				return "value is too long for the field";
+			}
+			if (length > 0) {
+				memcpy(data + 1, node::Buffer::Data(value->ToObject()),
+					length);
+			}
+		}
+		data[0] = (unsigned char) (length + 1);
+		written = length + 1;
+		return NULL;
+	}
+
+	if (length > remaining) {
+		return "buffer is shorter than the record";
+	}
+	written = length;
+
+	switch (field.format) {
+	case 'X':
+		memset(data, transcode::Blank(codePage), length);
+		return NULL;
+
+	case 'A': {
+		// Value is padded with blanks.
+		size_t stringLength = 0;
+		if (!missing) {
+			const char* rc = transcode::WriteString(codePage, value, data,
+				length, stringLength);
+			if (rc != NULL) {
+				return rc;
+			}
+		}
+		memset(data + stringLength, transcode::Blank(codePage),
+			length - stringLength);
+		return NULL;
+	}
+
+	case 'B':
+		if (node::Buffer::HasInstance(value)) {
+			v8::Local<v8::Object> buffer = value->ToObject();
+			if (node::Buffer::Length(buffer) != length) {
+				return "invalid length of the binary value";
+			}
+			memcpy(data, node::Buffer::Data(buffer), length);
+			return NULL;
+		}
+		if (missing) {
+			memset(data, 0, length);
+			return NULL;
+		}
+		if (length != 1 && length != 2 && length != 4) {
+			return "value of the binary field must be a buffer";
+		}
+		codec::EncodeBinary(value->Uint32Value(), data, length);
+		return NULL;
+
+	case 'F': {
+		double number = missing ? 0 : value->NumberValue();
+		if (number != number || number > codec::MAX_EXACT_DOUBLE ||
+			number < -codec::MAX_EXACT_DOUBLE)
+		{
+			return "value must be an exact number";
+		}
+		int64_t integer = int64_t(number < 0 ? number - 0.5 : number + 0.5);
+		if (length < 8) {
+			int64_t limit = int64_t(1) << (length * 8 - 1);
+			if (integer >= limit || integer < -limit) {
+				return "value is out of range of the field";
+			}
+		}
+		codec::EncodeFixed(integer, data, length);
+		return NULL;
+	}
+
+	case 'G':
+		codec::EncodeFloat(missing ? 0 : value->NumberValue(), data,
+			length);
+		return NULL;
+
+	case 'P':
+	case 'U':
+		return EncodeDecimal(field.format, value, missing, data, length);
+	}
+
+	return "unsupported format of the field";
+}
+
+/*
+ * Encodes object into the record buffer: encode(object, buffer
+ * [, command]). Returns length of the record. If command is passed,
+ * buffer becomes its record buffer and record buffer length is set.
+ */
+v8::Handle<v8::Value>
+FormatBuffer::Encode(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	FormatBuffer* self = ObjectWrap::Unwrap<FormatBuffer>(args.This());
+
+	unsigned int numArgs = args.Length();
+	if (numArgs < 2 || numArgs > 3) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	if (!args[0]->IsObject()) {
+		return V8_ERROR("first argument must be an object");
+	}
+	v8::Local<v8::Object> record = args[0]->ToObject();
+
+	if (!node::Buffer::HasInstance(args[1])) {
+		return V8_ERROR("second argument must be a buffer");
+	}
+	v8::Local<v8::Object> buffer = args[1]->ToObject();
+	unsigned char* data = (unsigned char*) node::Buffer::Data(buffer);
+	size_t bufferLength = node::Buffer::Length(buffer);
+
+	Command* commandPtr = NULL;
+	if (numArgs == 3) {
+		commandPtr = Command::FromValue(args[2]);
+		if (commandPtr == NULL) {
+			return V8_ERROR(
+				"third argument must be an Adabas control block");
+		}
+	}
+
+	size_t length = 0;
+	for (size_t i = 0; i < self->m_fields.size(); i++) {
+		const Field& field = self->m_fields[i];
+
+		v8::Local<v8::Value> value;
+		if (field.format == 'X') {
+			value = v8::Local<v8::Value>::New(v8::Undefined());
+		} else {
+			value = record->Get(self->m_names[i]);
+		}
+
+		size_t written;
+		const char* rc = EncodeValue(field, value, self->m_codePage,
+			data + length, bufferLength - length, written);
+		if (rc != NULL) {
+			return V8_ERROR(rc);
+		}
+		length += written;
+	}
+
+	if (commandPtr != NULL) {
+		if (length > 0xFFFF) {
+			return V8_ERROR("record is too long");
+		}
+		commandPtr->SetBuffer(1, buffer);
+		commandPtr->m_cb.cb_rec_buf_lng = (unsigned short) length;
+	}
+
+	return scope.Close(v8::Integer::NewFromUnsigned(length));
+}
+
+/*
+ * Returns length of the record (minimal length, when there are variable
+ * length fields).
+ */
+v8::Handle<v8::Value>
+FormatBuffer::GetRecordLength(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	FormatBuffer* self = ObjectWrap::Unwrap<FormatBuffer>(args.This());
+
+	if (args.Length() != 0) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	return scope.Close(v8::Integer::NewFromUnsigned(self->m_recordLength));
+}
+
+/*
+ * Returns format buffer string.
+ */
+v8::Handle<v8::Value>
+FormatBuffer::ToString(const v8::Arguments& args)
+{
+	v8::HandleScope scope;
+	FormatBuffer* self = ObjectWrap::Unwrap<FormatBuffer>(args.This());
+
+	if (args.Length() != 0) {
+		return V8_ERROR("wrong number of arguments");
+	}
+
+	return scope.Close(v8::String::New(self->m_format.c_str()));
+}
+
+} // namespace node_adabas
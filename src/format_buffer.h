@@ -0,0 +1,78 @@
+#ifndef NODE_ADABAS_SRC_FORMAT_BUFFER_H
+#define NODE_ADABAS_SRC_FORMAT_BUFFER_H
+
+#include <map>
+#include <node.h>
+#include <string>
+#include <vector>
+
+#include "transcode.h"
+
+namespace node_adabas {
+
+/*
+ * Compiled format buffer: table of fields, which decodes record buffers
+ * into JS objects.
+ */
+class FormatBuffer : public node::ObjectWrap {
+public:
+	/*
+	 * Field of the format buffer.
+	 */
+	struct Field {
+		// Field name (empty for skipped bytes 'nX').
+		std::string name;
+		// Format of the field: 'A', 'B', 'F', 'G', 'P', 'U' or 'X'.
+		char format;
+		// Length of the field (0 - variable length with length byte).
+		uint32_t length;
+	};
+
+private:
+	static v8::Persistent<v8::Function> constructor;
+
+	// Compiled format buffers by format buffer string.
+	static std::map<std::string, v8::Persistent<v8::Object> > cache;
+
+	std::string m_format;
+	// Code page of alphanumeric fields.
+	transcode::CodePage m_codePage;
+	std::vector<Field> m_fields;
+	// Minimal length of the record (length of fixed length fields).
+	uint32_t m_recordLength;
+	// Flag is true when there are variable length fields.
+	bool m_variableLength;
+	// Flags of the fields decoded by column kernels (decimals).
+	std::vector<bool> m_columns;
+
+	// Template of decoded records (all records have the same hidden
+	// class) and field names for the fields of the table.
+	v8::Persistent<v8::ObjectTemplate> m_template;
+	std::vector<v8::Persistent<v8::String> > m_names;
+
+private:
+	FormatBuffer();
+	~FormatBuffer();
+
+	const char* Compile(const std::string& format);
+	const char* DecodeRecord(const unsigned char* data, size_t remaining,
+		const double* columnValues, v8::Local<v8::Object>& record);
+
+	static v8::Handle<v8::Value> New(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Decode(const v8::Arguments& args);
+	static v8::Handle<v8::Value> DecodeMany(const v8::Arguments& args);
+	static v8::Handle<v8::Value> Encode(const v8::Arguments& args);
+	static v8::Handle<v8::Value> GetRecordLength(const v8::Arguments& args);
+	static v8::Handle<v8::Value> ToString(const v8::Arguments& args);
+
+	static v8::Handle<v8::Value> CompileFormat(const v8::Arguments& args);
+
+public:
+	static const char* Parse(const std::string& format,
+		std::vector<Field>& fields);
+	static void Initialize(v8::Handle<v8::Object> exports);
+};
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_FORMAT_BUFFER_H
@@ -0,0 +1,110 @@
+#include "histogram.h"
+
+// Number of sub-buckets per power of two.
+#define SUB_BUCKETS (1u << Histogram::SUB_BUCKET_BITS)
+
+namespace node_adabas {
+
+/*
+ * Constructor.
+ */
+Histogram::Histogram() :
+	m_counts((MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS, 0)
+{
+	Reset();
+}
+
+/*
+ * Returns index of the bucket of the value. Values below SUB_BUCKETS
+ * have own buckets, larger values are grouped by the exponent and the
+ * highest bits of the mantissa.
+ */
+size_t
+Histogram::BucketIndex(uint64_t value)
+{
+	if (value < SUB_BUCKETS) {
+		return size_t(value);
+	}
+	if (value >= (uint64_t(1) << MAX_EXPONENT)) {
+		value = (uint64_t(1) << MAX_EXPONENT) - 1;
+	}
+
+	unsigned int exponent = SUB_BUCKET_BITS;
+	while ((value >> (exponent + 1)) != 0) {
+		exponent++;
+	}
+	size_t subBucket = size_t(value >> (exponent - SUB_BUCKET_BITS)) &
+		(SUB_BUCKETS - 1);
+	return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+/*
+ * Returns the middle value of the bucket.
+ */
+uint64_t
+Histogram::BucketValue(size_t index)
+{
+	if (index < SUB_BUCKETS) {
+		return index;
+	}
+	unsigned int exponent =
+		unsigned(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+	uint64_t subBucket = index % SUB_BUCKETS;
+	unsigned int shift = exponent - SUB_BUCKET_BITS;
+	return ((SUB_BUCKETS + subBucket) << shift) +
+		((uint64_t(1) << shift) >> 1);
+}
+
+void
+Histogram::Record(uint64_t value)
+{
+	m_counts[BucketIndex(value)]++;
+	if (m_count == 0 || value < m_min) {
+		m_min = value;
+	}
+	if (value > m_max) {
+		m_max = value;
+	}
+	m_count++;
+	m_sum += double(value);
+}
+
+void
+Histogram::Reset(void)
+{
+	for (size_t i = 0; i < m_counts.size(); i++) {
+		m_counts[i] = 0;
+	}
+	m_count = 0;
+	m_min = 0;
+	m_max = 0;
+	m_sum = 0;
+}
+
+uint64_t
+Histogram::Percentile(double percentile) const
+{
+	if (m_count == 0) {
+		return 0;
+	}
+	if (percentile >= 100) {
+		return m_max;
+	}
+
+	uint64_t rank = uint64_t(percentile / 100 * double(m_count) + 0.5);
+	if (rank < 1) {
+		rank = 1;
+	}
+	uint64_t count = 0;
+	for (size_t i = 0; i < m_counts.size(); i++) {
+		count += m_counts[i];
+		if (count >= rank) {
+			// Value of the bucket is limited by the recorded range.
+			uint64_t value = BucketValue(i);
+			return value < m_min ? m_min : value > m_max ? m_max : value;
+		}
+	}
+	return m_max;
+}
+
+} // namespace node_adabas
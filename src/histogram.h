@@ -0,0 +1,58 @@
+#ifndef NODE_ADABAS_SRC_HISTOGRAM_H
+#define NODE_ADABAS_SRC_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace node_adabas {
+
+/*
+ * Histogram of values with logarithmic buckets (HDR-style): each power
+ * of two is split into 2^SUB_BUCKET_BITS linear sub-buckets, so values
+ * are recorded with relative error below 1/16. Not thread-safe.
+ */
+class Histogram {
+public:
+	static const unsigned int SUB_BUCKET_BITS = 4;
+	// Values above 2^MAX_EXPONENT are recorded as the maximal value.
+	static const unsigned int MAX_EXPONENT = 48;
+
+private:
+	std::vector<uint64_t> m_counts;
+	uint64_t m_count;
+	uint64_t m_min;
+	uint64_t m_max;
+	double m_sum;
+
+	static size_t BucketIndex(uint64_t value);
+	static uint64_t BucketValue(size_t index);
+
+public:
+	Histogram();
+
+	void Record(uint64_t value);
+	void Reset(void);
+
+	uint64_t Count(void) const {
+		return m_count;
+	}
+	uint64_t Min(void) const {
+		return m_min;
+	}
+	uint64_t Max(void) const {
+		return m_max;
+	}
+	double Mean(void) const {
+		return m_count > 0 ? m_sum / m_count : 0;
+	}
+
+	/*
+	 * Returns value at the percentile (0..100).
+	 */
+	uint64_t Percentile(double percentile) const;
+};
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_HISTOGRAM_H
@@ -0,0 +1,212 @@
+#include <sstream>
+#include <string.h>
+
+#include "atomic.h"
+#include "metrics.h"
+
+namespace node_adabas {
+
+const uint64_t Metrics::latencyBounds[NUM_LATENCY_BUCKETS] = {
+	100000ULL, 250000ULL, 500000ULL,
+	1000000ULL, 2500000ULL, 5000000ULL,
+	10000000ULL, 25000000ULL, 50000000ULL,
+	100000000ULL, 250000000ULL, 500000000ULL,
+	1000000000ULL, 2500000000ULL, 5000000000ULL,
+	10000000000ULL
+};
+
+/*
+ * Returns key of the series. Keys sort series by command code, database
+ * ID, file number and response code.
+ */
+static uint64_t
+MakeKey(const char* commandCode, uint16_t dbId, uint16_t fileNo,
+	uint16_t responseCode)
+{
+	return (uint64_t((unsigned char) commandCode[0]) << 56) |
+		(uint64_t((unsigned char) commandCode[1]) << 48) |
+		(uint64_t(dbId) << 32) |
+		(uint64_t(fileNo) << 16) |
+		uint64_t(responseCode);
+}
+
+/*
+ * Constructor.
+ */
+Metrics::Shard::Shard() :
+	m_entries(SHARD_CAPACITY + 1)
+{
+	Entry& overflow = m_entries[SHARD_CAPACITY];
+	overflow.key = MakeKey("??", 0, 0, 0);
+	memcpy(overflow.series.commandCode, "??", 2);
+	overflow.used = 1;
+}
+
+/*
+ * Returns entry of the series, adds the series if it isn't found or
+ * returns the overflow entry if the table is full (in thread of the
+ * shard).
+ */
+Metrics::Shard::Entry&
+Metrics::Shard::FindEntry(uint64_t key, const char* commandCode,
+	uint16_t dbId, uint16_t fileNo, uint16_t responseCode)
+{
+	size_t index = size_t((key * 0x9E3779B97F4A7C15ULL) >> 56) &
+		(SHARD_CAPACITY - 1);
+	for (unsigned int i = 0; i < SHARD_CAPACITY; i++) {
+		Entry& entry = m_entries[index];
+		if (!entry.used) {
+			// Entry is published after it is initialized.
+			entry.key = key;
+			memcpy(entry.series.commandCode, commandCode, 2);
+			entry.series.dbId = dbId;
+			entry.series.fileNo = fileNo;
+			entry.series.responseCode = responseCode;
+			AtomicStore(&entry.used, 1);
+			return entry;
+		}
+		if (entry.key == key) {
+			return entry;
+		}
+		index = (index + 1) & (SHARD_CAPACITY - 1);
+	}
+	return m_entries[SHARD_CAPACITY];
+}
+
+void
+Metrics::Shard::Record(const char* commandCode, uint16_t dbId,
+	uint16_t fileNo, uint16_t responseCode, uint64_t time)
+{
+	uint64_t key = MakeKey(commandCode, dbId, fileNo, responseCode);
+	Entry& entry = FindEntry(key, commandCode, dbId, fileNo, responseCode);
+
+	unsigned int bucket = 0;
+	while (bucket < NUM_LATENCY_BUCKETS && time > latencyBounds[bucket]) {
+		bucket++;
+	}
+
+	uint32_t sequence = entry.sequence;
+	AtomicStore(&entry.sequence, sequence + 1);
+	AtomicFence();
+	entry.series.count++;
+	entry.series.totalTime += time;
+	entry.series.buckets[bucket]++;
+	AtomicStore(&entry.sequence, sequence + 2);
+}
+
+void
+Metrics::Shard::Collect(SeriesMap& seriesMap) const
+{
+	for (size_t index = 0; index < m_entries.size(); index++) {
+		const Entry& entry = m_entries[index];
+		if (!AtomicLoad(&entry.used)) {
+			continue;
+		}
+
+		// Copy is retried while the thread updates the entry.
+		Series copy;
+		for (;;) {
+			uint32_t sequence = AtomicLoad(&entry.sequence);
+			if (sequence & 1) {
+				continue;
+			}
+			copy = entry.series;
+			AtomicFence();
+			if (entry.sequence == sequence) {
+				break;
+			}
+		}
+		if (copy.count == 0) {
+			continue;
+		}
+
+		SeriesMap::iterator it = seriesMap.find(entry.key);
+		if (it == seriesMap.end()) {
+			seriesMap[entry.key] = copy;
+			continue;
+		}
+		Series& series = it->second;
+		series.count += copy.count;
+		series.totalTime += copy.totalTime;
+		for (unsigned int bucket = 0; bucket <= NUM_LATENCY_BUCKETS;
+			bucket++)
+		{
+			series.buckets[bucket] += copy.buckets[bucket];
+		}
+	}
+}
+
+/*
+ * Writes labels of the series. Unprintable characters of the command
+ * code are replaced with '?'.
+ */
+static void
+WriteLabels(std::ostringstream& out, const Metrics::Series& series)
+{
+	out << "command=\"";
+	for (int i = 0; i < 2; i++) {
+		char c = series.commandCode[i];
+		out << (c >= 0x20 && c < 0x7F && c != '"' && c != '\\' ? c : '?');
+	}
+	out << "\",dbid=\"" << series.dbId << "\",file=\"" << series.fileNo
+		<< "\",response=\"";
+	if (series.responseCode == Metrics::RESPONSE_CALL_FAILED) {
+		out << "error";
+	} else {
+		out << series.responseCode;
+	}
+	out << "\"";
+}
+
+std::string
+Metrics::RenderPrometheus(const SeriesMap& seriesMap,
+	const std::string& prefix)
+{
+	std::ostringstream out;
+	out.precision(9);
+
+	out << "# HELP " << prefix << "_commands_total Adabas calls by"
+		" command code, database ID, file number and response code.\n"
+		<< "# TYPE " << prefix << "_commands_total counter\n";
+	for (SeriesMap::const_iterator it = seriesMap.begin();
+		it != seriesMap.end(); ++it)
+	{
+		out << prefix << "_commands_total{";
+		WriteLabels(out, it->second);
+		out << "} " << it->second.count << "\n";
+	}
+
+	out << "# HELP " << prefix << "_command_duration_seconds Duration"
+		" of Adabas calls.\n"
+		<< "# TYPE " << prefix << "_command_duration_seconds histogram\n";
+	for (SeriesMap::const_iterator it = seriesMap.begin();
+		it != seriesMap.end(); ++it)
+	{
+		const Series& series = it->second;
+		uint64_t count = 0;
+		for (unsigned int bucket = 0; bucket <= NUM_LATENCY_BUCKETS;
+			bucket++)
+		{
+			count += series.buckets[bucket];
+			out << prefix << "_command_duration_seconds_bucket{";
+			WriteLabels(out, series);
+			out << ",le=\"";
+			if (bucket < NUM_LATENCY_BUCKETS) {
+				out << double(latencyBounds[bucket]) / 1e9;
+			} else {
+				out << "+Inf";
+			}
+			out << "\"} " << count << "\n";
+		}
+		out << prefix << "_command_duration_seconds_sum{";
+		WriteLabels(out, series);
+		out << "} " << double(series.totalTime) / 1e9 << "\n";
+		out << prefix << "_command_duration_seconds_count{";
+		WriteLabels(out, series);
+		out << "} " << series.count << "\n";
+	}
+
+	return out.str();
+}
+
+} // namespace node_adabas
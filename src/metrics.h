@@ -0,0 +1,98 @@
+#ifndef NODE_ADABAS_SRC_METRICS_H
+#define NODE_ADABAS_SRC_METRICS_H
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace node_adabas {
+
+/*
+ * Counters and latency histograms of Adabas calls by command code,
+ * database ID, file number and response code. Each thread records calls
+ * into its own shard, main thread sums shards without locks.
+ */
+class Metrics {
+public:
+	// Number of latency buckets (their upper bounds are in
+	// latencyBounds, the last bucket is '+Inf').
+	static const unsigned int NUM_LATENCY_BUCKETS = 16;
+	// Number of series in the shard (power of two).
+	static const unsigned int SHARD_CAPACITY = 256;
+	// Response code of the series of calls which failed (rc != 0).
+	static const uint32_t RESPONSE_CALL_FAILED = 0xFFFF;
+
+	// Upper bounds of latency buckets in nanoseconds.
+	static const uint64_t latencyBounds[NUM_LATENCY_BUCKETS];
+
+	/*
+	 * Calls with the same command code, database ID, file number and
+	 * response code. Series with command code '??' counts calls, which
+	 * didn't fit into the shard.
+	 */
+	struct Series {
+		char commandCode[2];
+		uint16_t dbId;
+		uint16_t fileNo;
+		uint16_t responseCode;
+		uint64_t count;
+		// Total duration of calls in nanoseconds.
+		uint64_t totalTime;
+		// Number of calls in latency buckets (not cumulative).
+		uint64_t buckets[NUM_LATENCY_BUCKETS + 1];
+	};
+
+	/*
+	 * Series of calls sorted by key.
+	 */
+	typedef std::map<uint64_t, Series> SeriesMap;
+
+	/*
+	 * Series of one thread. Shard is written by its thread only and
+	 * read by main thread, each entry is guarded by sequence number
+	 * (odd while the entry is written), so the reader retries instead of
+	 * locking. Shard doesn't allocate memory after construction.
+	 */
+	class Shard {
+		struct Entry {
+			// Flag is set when key and series are initialized.
+			volatile uint32_t used;
+			volatile uint32_t sequence;
+			uint64_t key;
+			Series series;
+		};
+
+		// Table of series with open addressing and the overflow entry.
+		std::vector<Entry> m_entries;
+
+		Entry& FindEntry(uint64_t key, const char* commandCode,
+			uint16_t dbId, uint16_t fileNo, uint16_t responseCode);
+
+	public:
+		Shard();
+
+		/*
+		 * Records the call (in thread of the shard).
+		 */
+		void Record(const char* commandCode, uint16_t dbId,
+			uint16_t fileNo, uint16_t responseCode, uint64_t time);
+
+		/*
+		 * Adds series of the shard to the map (in main thread).
+		 */
+		void Collect(SeriesMap& series) const;
+	};
+
+	/*
+	 * Renders series in Prometheus text format: counter
+	 * <prefix>_commands_total and histogram
+	 * <prefix>_command_duration_seconds.
+	 */
+	static std::string RenderPrometheus(const SeriesMap& series,
+		const std::string& prefix);
+};
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_METRICS_H
@@ -29,6 +29,7 @@
 #include <node.h>
 #include "adabas.h"
 #include "command.h"
+#include "format_buffer.h"
 
 using namespace node_adabas;
 
@@ -41,6 +42,7 @@ void
 RegisterModule(v8::Handle<v8::Object> exports) {
 	Adabas::Initialize(exports);
 	Command::Initialize(exports);
+	FormatBuffer::Initialize(exports);
 }
 
 } // namespace
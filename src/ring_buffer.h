@@ -0,0 +1,193 @@
+#ifndef NODE_ADABAS_SRC_RING_BUFFER_H
+#define NODE_ADABAS_SRC_RING_BUFFER_H
+
+#include <vector>
+
+#include "atomic.h"
+
+namespace node_adabas {
+
+// Size of the padding which keeps producer and consumer positions
+// in different cache lines.
+#define RING_BUFFER_PADDING 64
+
+/*
+ * Bounded lock-free queue for multiple producers and multiple consumers
+ * (D. Vyukov's algorithm). Capacity is rounded up to a power of two,
+ * memory is allocated only in Init().
+ */
+template <typename T>
+class MpmcRing {
+private:
+	struct Cell {
+		volatile uint32_t sequence;
+		T value;
+	};
+
+	std::vector<Cell> m_cells;
+	uint32_t m_mask;
+	char m_padding1[RING_BUFFER_PADDING];
+	volatile uint32_t m_enqueuePos;
+	char m_padding2[RING_BUFFER_PADDING];
+	volatile uint32_t m_dequeuePos;
+	char m_padding3[RING_BUFFER_PADDING];
+
+public:
+	MpmcRing() : m_mask(0), m_enqueuePos(0), m_dequeuePos(0) {}
+
+	void Init(uint32_t capacity)
+	{
+		uint32_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+
+		m_cells.resize(size);
+		for (uint32_t i = 0; i < size; i++) {
+			m_cells[i].sequence = i;
+		}
+		m_mask = size - 1;
+		m_enqueuePos = 0;
+		m_dequeuePos = 0;
+		AtomicFence();
+	}
+
+	uint32_t Capacity(void) const
+	{
+		return m_mask + 1;
+	}
+
+	bool Push(const T& value)
+	{
+		Cell* cell;
+		uint32_t pos = AtomicLoad(&m_enqueuePos);
+		for (;;) {
+			cell = &m_cells[pos & m_mask];
+			int32_t diff = (int32_t) (AtomicLoad(&cell->sequence) - pos);
+			if (diff == 0) {
+				if (AtomicCompareExchange(&m_enqueuePos, pos, pos + 1)) {
+					break;
+				}
+			} else if (diff < 0) {
+				// Queue is full.
+				return false;
+			}
+			pos = AtomicLoad(&m_enqueuePos);
+		}
+
+		cell->value = value;
+		AtomicStore(&cell->sequence, pos + 1);
+		return true;
+	}
+
+	bool Pop(T& value)
+	{
+		Cell* cell;
+		uint32_t pos = AtomicLoad(&m_dequeuePos);
+		for (;;) {
+			cell = &m_cells[pos & m_mask];
+			int32_t diff =
+				(int32_t) (AtomicLoad(&cell->sequence) - (pos + 1));
+			if (diff == 0) {
+				if (AtomicCompareExchange(&m_dequeuePos, pos, pos + 1)) {
+					break;
+				}
+			} else if (diff < 0) {
+				// Queue is empty.
+				return false;
+			}
+			pos = AtomicLoad(&m_dequeuePos);
+		}
+
+		value = cell->value;
+		AtomicStore(&cell->sequence, pos + m_mask + 1);
+		return true;
+	}
+
+	// Returns approximate number of elements in the queue.
+	uint32_t Size(void) const
+	{
+		uint32_t dequeuePos = AtomicLoad(&m_dequeuePos);
+		int32_t size = (int32_t) (AtomicLoad(&m_enqueuePos) - dequeuePos);
+		return size > 0 ? (uint32_t) size : 0;
+	}
+
+	bool Empty(void) const
+	{
+		return Size() == 0;
+	}
+};
+
+/*
+ * Bounded wait-free queue for single producer and single consumer.
+ * Capacity is rounded up to a power of two, memory is allocated only
+ * in Init().
+ */
+template <typename T>
+class SpscRing {
+private:
+	std::vector<T> m_values;
+	uint32_t m_mask;
+	char m_padding1[RING_BUFFER_PADDING];
+	volatile uint32_t m_head;
+	char m_padding2[RING_BUFFER_PADDING];
+	volatile uint32_t m_tail;
+	char m_padding3[RING_BUFFER_PADDING];
+
+public:
+	SpscRing() : m_mask(0), m_head(0), m_tail(0) {}
+
+	void Init(uint32_t capacity)
+	{
+		uint32_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+
+		m_values.resize(size);
+		m_mask = size - 1;
+		m_head = 0;
+		m_tail = 0;
+		AtomicFence();
+	}
+
+	// Called only by the producer.
+	bool Push(const T& value)
+	{
+		uint32_t tail = m_tail;
+		if (tail - AtomicLoad(&m_head) > m_mask) {
+			// Queue is full.
+			return false;
+		}
+		m_values[tail & m_mask] = value;
+		AtomicStore(&m_tail, tail + 1);
+		return true;
+	}
+
+	// Called only by the consumer.
+	bool Pop(T& value)
+	{
+		uint32_t head = m_head;
+		if (head == AtomicLoad(&m_tail)) {
+			// Queue is empty.
+			return false;
+		}
+		value = m_values[head & m_mask];
+		AtomicStore(&m_head, head + 1);
+		return true;
+	}
+
+	uint32_t Size(void) const
+	{
+		return AtomicLoad(&m_tail) - AtomicLoad(&m_head);
+	}
+
+	bool Empty(void) const
+	{
+		return Size() == 0;
+	}
+};
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_RING_BUFFER_H
@@ -0,0 +1,455 @@
+#include <cstring>
+#include <vector>
+
+#include "codec.h"
+#include "transcode.h"
+
+#ifdef CODEC_SSE2
+#include <emmintrin.h>
+#endif // CODEC_SSE2
+
+// Length of strings converted in the stack buffers.
+#define STACK_STRING_LENGTH 256
+
+namespace node_adabas {
+
+namespace transcode {
+
+/*
+ * Code page 037 (EBCDIC) to Latin-1.
+ */
+static const unsigned char cp037ToLatin1[256] = {
+	0x00, 0x01, 0x02, 0x03, 0x9C, 0x09, 0x86, 0x7F,
+	0x97, 0x8D, 0x8E, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	0x10, 0x11, 0x12, 0x13, 0x9D, 0x85, 0x08, 0x87,
+	0x18, 0x19, 0x92, 0x8F, 0x1C, 0x1D, 0x1E, 0x1F,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x0A, 0x17, 0x1B,
+	0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x05, 0x06, 0x07,
+	0x90, 0x91, 0x16, 0x93, 0x94, 0x95, 0x96, 0x04,
+	0x98, 0x99, 0x9A, 0x9B, 0x14, 0x15, 0x9E, 0x1A,
+	0x20, 0xA0, 0xE2, 0xE4, 0xE0, 0xE1, 0xE3, 0xE5,
+	0xE7, 0xF1, 0xA2, 0x2E, 0x3C, 0x28, 0x2B, 0x7C,
+	0x26, 0xE9, 0xEA, 0xEB, 0xE8, 0xED, 0xEE, 0xEF,
+	0xEC, 0xDF, 0x21, 0x24, 0x2A, 0x29, 0x3B, 0xAC,
+	0x2D, 0x2F, 0xC2, 0xC4, 0xC0, 0xC1, 0xC3, 0xC5,
+	0xC7, 0xD1, 0xA6, 0x2C, 0x25, 0x5F, 0x3E, 0x3F,
+	0xF8, 0xC9, 0xCA, 0xCB, 0xC8, 0xCD, 0xCE, 0xCF,
+	0xCC, 0x60, 0x3A, 0x23, 0x40, 0x27, 0x3D, 0x22,
+	0xD8, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+	0x68, 0x69, 0xAB, 0xBB, 0xF0, 0xFD, 0xFE, 0xB1,
+	0xB0, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 0x70,
+	0x71, 0x72, 0xAA, 0xBA, 0xE6, 0xB8, 0xC6, 0xA4,
+	0xB5, 0x7E, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+	0x79, 0x7A, 0xA1, 0xBF, 0xD0, 0xDD, 0xDE, 0xAE,
+	0x5E, 0xA3, 0xA5, 0xB7, 0xA9, 0xA7, 0xB6, 0xBC,
+	0xBD, 0xBE, 0x5B, 0x5D, 0xAF, 0xA8, 0xB4, 0xD7,
+	0x7B, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+	0x48, 0x49, 0xAD, 0xF4, 0xF6, 0xF2, 0xF3, 0xF5,
+	0x7D, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50,
+	0x51, 0x52, 0xB9, 0xFB, 0xFC, 0xF9, 0xFA, 0xFF,
+	0x5C, 0xF7, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+	0x59, 0x5A, 0xB2, 0xD4, 0xD6, 0xD2, 0xD3, 0xD5,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+	0x38, 0x39, 0xB3, 0xDB, 0xDC, 0xD9, 0xDA, 0x9F
+};
+
+/*
+ * Latin-1 to code page 037 (EBCDIC).
+ */
+static const unsigned char latin1ToCp037[256] = {
+	0x00, 0x01, 0x02, 0x03, 0x37, 0x2D, 0x2E, 0x2F,
+	0x16, 0x05, 0x25, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	0x10, 0x11, 0x12, 0x13, 0x3C, 0x3D, 0x32, 0x26,
+	0x18, 0x19, 0x3F, 0x27, 0x1C, 0x1D, 0x1E, 0x1F,
+	0x40, 0x5A, 0x7F, 0x7B, 0x5B, 0x6C, 0x50, 0x7D,
+	0x4D, 0x5D, 0x5C, 0x4E, 0x6B, 0x60, 0x4B, 0x61,
+	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7,
+	0xF8, 0xF9, 0x7A, 0x5E, 0x4C, 0x7E, 0x6E, 0x6F,
+	0x7C, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+	0xC8, 0xC9, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6,
+	0xD7, 0xD8, 0xD9, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6,
+	0xE7, 0xE8, 0xE9, 0xBA, 0xE0, 0xBB, 0xB0, 0x6D,
+	0x79, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96,
+	0x97, 0x98, 0x99, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6,
+	0xA7, 0xA8, 0xA9, 0xC0, 0x4F, 0xD0, 0xA1, 0x07,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x15, 0x06, 0x17,
+	0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x09, 0x0A, 0x1B,
+	0x30, 0x31, 0x1A, 0x33, 0x34, 0x35, 0x36, 0x08,
+	0x38, 0x39, 0x3A, 0x3B, 0x04, 0x14, 0x3E, 0xFF,
+	0x41, 0xAA, 0x4A, 0xB1, 0x9F, 0xB2, 0x6A, 0xB5,
+	0xBD, 0xB4, 0x9A, 0x8A, 0x5F, 0xCA, 0xAF, 0xBC,
+	0x90, 0x8F, 0xEA, 0xFA, 0xBE, 0xA0, 0xB6, 0xB3,
+	0x9D, 0xDA, 0x9B, 0x8B, 0xB7, 0xB8, 0xB9, 0xAB,
+	0x64, 0x65, 0x62, 0x66, 0x63, 0x67, 0x9E, 0x68,
+	0x74, 0x71, 0x72, 0x73, 0x78, 0x75, 0x76, 0x77,
+	0xAC, 0x69, 0xED, 0xEE, 0xEB, 0xEF, 0xEC, 0xBF,
+	0x80, 0xFD, 0xFE, 0xFB, 0xFC, 0xAD, 0xAE, 0x59,
+	0x44, 0x45, 0x42, 0x46, 0x43, 0x47, 0x9C, 0x48,
+	0x54, 0x51, 0x52, 0x53, 0x58, 0x55, 0x56, 0x57,
+	0x8C, 0x49, 0xCD, 0xCE, 0xCB, 0xCF, 0xCC, 0xE1,
+	0x70, 0xDD, 0xDE, 0xDB, 0xDC, 0x8D, 0x8E, 0xDF
+};
+
+/*
+ * Code page 500 (EBCDIC) to Latin-1.
+ */
+static const unsigned char cp500ToLatin1[256] = {
+	0x00, 0x01, 0x02, 0x03, 0x9C, 0x09, 0x86, 0x7F,
+	0x97, 0x8D, 0x8E, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	0x10, 0x11, 0x12, 0x13, 0x9D, 0x85, 0x08, 0x87,
+	0x18, 0x19, 0x92, 0x8F, 0x1C, 0x1D, 0x1E, 0x1F,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x0A, 0x17, 0x1B,
+	0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x05, 0x06, 0x07,
+	0x90, 0x91, 0x16, 0x93, 0x94, 0x95, 0x96, 0x04,
+	0x98, 0x99, 0x9A, 0x9B, 0x14, 0x15, 0x9E, 0x1A,
+	0x20, 0xA0, 0xE2, 0xE4, 0xE0, 0xE1, 0xE3, 0xE5,
+	0xE7, 0xF1, 0x5B, 0x2E, 0x3C, 0x28, 0x2B, 0x21,
+	0x26, 0xE9, 0xEA, 0xEB, 0xE8, 0xED, 0xEE, 0xEF,
+	0xEC, 0xDF, 0x5D, 0x24, 0x2A, 0x29, 0x3B, 0x5E,
+	0x2D, 0x2F, 0xC2, 0xC4, 0xC0, 0xC1, 0xC3, 0xC5,
+	0xC7, 0xD1, 0xA6, 0x2C, 0x25, 0x5F, 0x3E, 0x3F,
+	0xF8, 0xC9, 0xCA, 0xCB, 0xC8, 0xCD, 0xCE, 0xCF,
+	0xCC, 0x60, 0x3A, 0x23, 0x40, 0x27, 0x3D, 0x22,
+	0xD8, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+	0x68, 0x69, 0xAB, 0xBB, 0xF0, 0xFD, 0xFE, 0xB1,
+	0xB0, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 0x70,
+	0x71, 0x72, 0xAA, 0xBA, 0xE6, 0xB8, 0xC6, 0xA4,
+	0xB5, 0x7E, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+	0x79, 0x7A, 0xA1, 0xBF, 0xD0, 0xDD, 0xDE, 0xAE,
+	0xA2, 0xA3, 0xA5, 0xB7, 0xA9, 0xA7, 0xB6, 0xBC,
+	0xBD, 0xBE, 0xAC, 0x7C, 0xAF, 0xA8, 0xB4, 0xD7,
+	0x7B, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+	0x48, 0x49, 0xAD, 0xF4, 0xF6, 0xF2, 0xF3, 0xF5,
+	0x7D, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50,
+	0x51, 0x52, 0xB9, 0xFB, 0xFC, 0xF9, 0xFA, 0xFF,
+	0x5C, 0xF7, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+	0x59, 0x5A, 0xB2, 0xD4, 0xD6, 0xD2, 0xD3, 0xD5,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+	0x38, 0x39, 0xB3, 0xDB, 0xDC, 0xD9, 0xDA, 0x9F
+};
+
+/*
+ * Latin-1 to code page 500 (EBCDIC).
+ */
+static const unsigned char latin1ToCp500[256] = {
+	0x00, 0x01, 0x02, 0x03, 0x37, 0x2D, 0x2E, 0x2F,
+	0x16, 0x05, 0x25, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	0x10, 0x11, 0x12, 0x13, 0x3C, 0x3D, 0x32, 0x26,
+	0x18, 0x19, 0x3F, 0x27, 0x1C, 0x1D, 0x1E, 0x1F,
+	0x40, 0x4F, 0x7F, 0x7B, 0x5B, 0x6C, 0x50, 0x7D,
+	0x4D, 0x5D, 0x5C, 0x4E, 0x6B, 0x60, 0x4B, 0x61,
+	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7,
+	0xF8, 0xF9, 0x7A, 0x5E, 0x4C, 0x7E, 0x6E, 0x6F,
+	0x7C, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+	0xC8, 0xC9, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6,
+	0xD7, 0xD8, 0xD9, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6,
+	0xE7, 0xE8, 0xE9, 0x4A, 0xE0, 0x5A, 0x5F, 0x6D,
+	0x79, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96,
+	0x97, 0x98, 0x99, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6,
+	0xA7, 0xA8, 0xA9, 0xC0, 0xBB, 0xD0, 0xA1, 0x07,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x15, 0x06, 0x17,
+	0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x09, 0x0A, 0x1B,
+	0x30, 0x31, 0x1A, 0x33, 0x34, 0x35, 0x36, 0x08,
+	0x38, 0x39, 0x3A, 0x3B, 0x04, 0x14, 0x3E, 0xFF,
+	0x41, 0xAA, 0xB0, 0xB1, 0x9F, 0xB2, 0x6A, 0xB5,
+	0xBD, 0xB4, 0x9A, 0x8A, 0xBA, 0xCA, 0xAF, 0xBC,
+	0x90, 0x8F, 0xEA, 0xFA, 0xBE, 0xA0, 0xB6, 0xB3,
+	0x9D, 0xDA, 0x9B, 0x8B, 0xB7, 0xB8, 0xB9, 0xAB,
+	0x64, 0x65, 0x62, 0x66, 0x63, 0x67, 0x9E, 0x68,
+	0x74, 0x71, 0x72, 0x73, 0x78, 0x75, 0x76, 0x77,
+	0xAC, 0x69, 0xED, 0xEE, 0xEB, 0xEF, 0xEC, 0xBF,
+	0x80, 0xFD, 0xFE, 0xFB, 0xFC, 0xAD, 0xAE, 0x59,
+	0x44, 0x45, 0x42, 0x46, 0x43, 0x47, 0x9C, 0x48,
+	0x54, 0x51, 0x52, 0x53, 0x58, 0x55, 0x56, 0x57,
+	0x8C, 0x49, 0xCD, 0xCE, 0xCB, 0xCF, 0xCC, 0xE1,
+	0x70, 0xDD, 0xDE, 0xDB, 0xDC, 0x8D, 0x8E, 0xDF
+};
+
+/*
+ * Code page 1047 (EBCDIC) to Latin-1.
+ */
+static const unsigned char cp1047ToLatin1[256] = {
+	0x00, 0x01, 0x02, 0x03, 0x9C, 0x09, 0x86, 0x7F,
+	0x97, 0x8D, 0x8E, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	0x10, 0x11, 0x12, 0x13, 0x9D, 0x85, 0x08, 0x87,
+	0x18, 0x19, 0x92, 0x8F, 0x1C, 0x1D, 0x1E, 0x1F,
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x0A, 0x17, 0x1B,
+	0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x05, 0x06, 0x07,
+	0x90, 0x91, 0x16, 0x93, 0x94, 0x95, 0x96, 0x04,
+	0x98, 0x99, 0x9A, 0x9B, 0x14, 0x15, 0x9E, 0x1A,
+	0x20, 0xA0, 0xE2, 0xE4, 0xE0, 0xE1, 0xE3, 0xE5,
+	0xE7, 0xF1, 0xA2, 0x2E, 0x3C, 0x28, 0x2B, 0x7C,
+	0x26, 0xE9, 0xEA, 0xEB, 0xE8, 0xED, 0xEE, 0xEF,
+	0xEC, 0xDF, 0x21, 0x24, 0x2A, 0x29, 0x3B, 0x5E,
+	0x2D, 0x2F, 0xC2, 0xC4, 0xC0, 0xC1, 0xC3, 0xC5,
+	0xC7, 0xD1, 0xA6, 0x2C, 0x25, 0x5F, 0x3E, 0x3F,
+	0xF8, 0xC9, 0xCA, 0xCB, 0xC8, 0xCD, 0xCE, 0xCF,
+	0xCC, 0x60, 0x3A, 0x23, 0x40, 0x27, 0x3D, 0x22,
+	0xD8, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+	0x68, 0x69, 0xAB, 0xBB, 0xF0, 0xFD, 0xFE, 0xB1,
+	0xB0, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 0x70,
+	0x71, 0x72, 0xAA, 0xBA, 0xE6, 0xB8, 0xC6, 0xA4,
+	0xB5, 0x7E, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+	0x79, 0x7A, 0xA1, 0xBF, 0xD0, 0x5B, 0xDE, 0xAE,
+	0xAC, 0xA3, 0xA5, 0xB7, 0xA9, 0xA7, 0xB6, 0xBC,
+	0xBD, 0xBE, 0xDD, 0xA8, 0xAF, 0x5D, 0xB4, 0xD7,
+	0x7B, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+	0x48, 0x49, 0xAD, 0xF4, 0xF6, 0xF2, 0xF3, 0xF5,
+	0x7D, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50,
+	0x51, 0x52, 0xB9, 0xFB, 0xFC, 0xF9, 0xFA, 0xFF,
+	0x5C, 0xF7, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+	0x59, 0x5A, 0xB2, 0xD4, 0xD6, 0xD2, 0xD3, 0xD5,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+	0x38, 0x39, 0xB3, 0xDB, 0xDC, 0xD9, 0xDA, 0x9F
+};
+
+/*
+ * Latin-1 to code page 1047 (EBCDIC).
+ */
+static const unsigned char latin1ToCp1047[256] = {
+	0x00, 0x01, 0x02, 0x03, 0x37, 0x2D, 0x2E, 0x2F,
+	0x16, 0x05, 0x25, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+	0x10, 0x11, 0x12, 0x13, 0x3C, 0x3D, 0x32, 0x26,
+	0x18, 0x19, 0x3F, 0x27, 0x1C, 0x1D, 0x1E, 0x1F,
+	0x40, 0x5A, 0x7F, 0x7B, 0x5B, 0x6C, 0x50, 0x7D,
+	0x4D, 0x5D, 0x5C, 0x4E, 0x6B, 0x60, 0x4B, 0x61,
+	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7,
+	0xF8, 0xF9, 0x7A, 0x5E, 0x4C, 0x7E, 0x6E, 0x6F,
+	0x7C, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+	0xC8, 0xC9, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6,
+	0xD7, 0xD8, 0xD9, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6,
+	0xE7, 0xE8, 0xE9, 0xAD, 0xE0, 0xBD, 0x5F, 0x6D,
+	0x79, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96,
+	0x97, 0x98, 0x99, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6,
+	0xA7, 0xA8, 0xA9, 0xC0, 0x4F, 0xD0, 0xA1, 0x07,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x15, 0x06, 0x17,
+	0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x09, 0x0A, 0x1B,
+	0x30, 0x31, 0x1A, 0x33, 0x34, 0x35, 0x36, 0x08,
+	0x38, 0x39, 0x3A, 0x3B, 0x04, 0x14, 0x3E, 0xFF,
+	0x41, 0xAA, 0x4A, 0xB1, 0x9F, 0xB2, 0x6A, 0xB5,
+	0xBB, 0xB4, 0x9A, 0x8A, 0xB0, 0xCA, 0xAF, 0xBC,
+	0x90, 0x8F, 0xEA, 0xFA, 0xBE, 0xA0, 0xB6, 0xB3,
+	0x9D, 0xDA, 0x9B, 0x8B, 0xB7, 0xB8, 0xB9, 0xAB,
+	0x64, 0x65, 0x62, 0x66, 0x63, 0x67, 0x9E, 0x68,
+	0x74, 0x71, 0x72, 0x73, 0x78, 0x75, 0x76, 0x77,
+	0xAC, 0x69, 0xED, 0xEE, 0xEB, 0xEF, 0xEC, 0xBF,
+	0x80, 0xFD, 0xFE, 0xFB, 0xFC, 0xBA, 0xAE, 0x59,
+	0x44, 0x45, 0x42, 0x46, 0x43, 0x47, 0x9C, 0x48,
+	0x54, 0x51, 0x52, 0x53, 0x58, 0x55, 0x56, 0x57,
+	0x8C, 0x49, 0xCD, 0xCE, 0xCB, 0xCF, 0xCC, 0xE1,
+	0x70, 0xDD, 0xDE, 0xDB, 0xDC, 0x8D, 0x8E, 0xDF
+};
+
+
+/*
+ * Tables of the code pages (NULL for Latin-1).
+ */
+struct CodePageInfo {
+	const char* name;
+	const unsigned char* toLatin1;
+	const unsigned char* fromLatin1;
+	unsigned char blank;
+};
+
+static const CodePageInfo codePages[] = {
+	{ "latin1", NULL, NULL, 0x20 },
+	{ "cp037", cp037ToLatin1, latin1ToCp037, 0x40 },
+	{ "cp500", cp500ToLatin1, latin1ToCp500, 0x40 },
+	{ "cp1047", cp1047ToLatin1, latin1ToCp1047, 0x40 }
+};
+
+bool
+FindCodePage(const char* name, CodePage& codePage)
+{
+	for (size_t i = 0; i < sizeof(codePages) / sizeof(codePages[0]); i++) {
+		if (strcmp(name, codePages[i].name) == 0) {
+			codePage = CodePage(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char*
+CodePageName(CodePage codePage)
+{
+	return codePages[codePage].name;
+}
+
+unsigned char
+Blank(CodePage codePage)
+{
+	return codePages[codePage].blank;
+}
+
+bool
+IsAscii(const unsigned char* data, size_t length)
+{
+	size_t i = 0;
+#ifdef CODEC_SSE2
+	__m128i bits = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16) {
+		bits = _mm_or_si128(bits, _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i)));
+	}
+	if (_mm_movemask_epi8(bits) != 0) {
+		return false;
+	}
+#endif // CODEC_SSE2
+	unsigned char bit = 0;
+	for (; i < length; i++) {
+		bit |= data[i];
+	}
+	return (bit & 0x80) == 0;
+}
+
+/*
+ * Translates bytes by the table (source and target may be the same).
+ */
+static void
+Translate(const unsigned char* table, const unsigned char* data,
+	size_t length, unsigned char* target)
+{
+	for (size_t i = 0; i < length; i++) {
+		target[i] = table[data[i]];
+	}
+}
+
+/*
+ * Converts Latin-1 bytes into UTF-16 text.
+ */
+static void
+Widen(const unsigned char* data, size_t length, uint16_t* text)
+{
+	size_t i = 0;
+#ifdef CODEC_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16) {
+		__m128i x = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(text + i),
+			_mm_unpacklo_epi8(x, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(text + i + 8),
+			_mm_unpackhi_epi8(x, zero));
+	}
+#endif // CODEC_SSE2
+	for (; i < length; i++) {
+		text[i] = data[i];
+	}
+}
+
+/*
+ * Converts UTF-16 text into Latin-1 bytes. Returns false if some
+ * character is not Latin-1 character.
+ */
+static bool
+Narrow(const uint16_t* text, size_t length, unsigned char* data)
+{
+	size_t i = 0;
+#ifdef CODEC_SSE2
+	const __m128i highBytes = _mm_set1_epi16(short(0xFF00));
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16) {
+		__m128i low = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(text + i));
+		__m128i high = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(text + i + 8));
+		__m128i wide = _mm_and_si128(_mm_or_si128(low, high), highBytes);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(wide, zero)) != 0xFFFF) {
+			return false;
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data + i),
+			_mm_packus_epi16(low, high));
+	}
+#endif // CODEC_SSE2
+	for (; i < length; i++) {
+		if (text[i] > 0xFF) {
+			return false;
+		}
+		data[i] = (unsigned char) text[i];
+	}
+	return true;
+}
+
+void
+Decode(CodePage codePage, const unsigned char* data, size_t length,
+	uint16_t* text)
+{
+	const unsigned char* table = codePages[codePage].toLatin1;
+	if (table == NULL) {
+		Widen(data, length, text);
+		return;
+	}
+	for (size_t i = 0; i < length; i++) {
+		text[i] = table[data[i]];
+	}
+}
+
+bool
+Encode(CodePage codePage, const uint16_t* text, size_t length,
+	unsigned char* data)
+{
+	if (!Narrow(text, length, data)) {
+		return false;
+	}
+	const unsigned char* table = codePages[codePage].fromLatin1;
+	if (table != NULL) {
+		Translate(table, data, length, data);
+	}
+	return true;
+}
+
+v8::Local<v8::String>
+NewString(CodePage codePage, const unsigned char* data, size_t length)
+{
+	// EBCDIC is translated into Latin-1 first.
+	unsigned char stackBytes[STACK_STRING_LENGTH];
+	std::vector<unsigned char> heapBytes;
+	const unsigned char* table = codePages[codePage].toLatin1;
+	if (table != NULL) {
+		unsigned char* bytes = stackBytes;
+		if (length > STACK_STRING_LENGTH) {
+			heapBytes.resize(length);
+			bytes = &heapBytes[0];
+		}
+		Translate(table, data, length, bytes);
+		data = bytes;
+	}
+
+	// ASCII string is created without conversion into UTF-16.
+	if (IsAscii(data, length)) {
+		return v8::String::New((const char*) data, int(length));
+	}
+
+	uint16_t stackText[STACK_STRING_LENGTH];
+	std::vector<uint16_t> heapText;
+	uint16_t* text = stackText;
+	if (length > STACK_STRING_LENGTH) {
+		heapText.resize(length);
+		text = &heapText[0];
+	}
+	Widen(data, length, text);
+	return v8::String::New(text, int(length));
+}
+
+const char*
+WriteString(CodePage codePage, v8::Handle<v8::Value> value,
+	unsigned char* data, size_t capacity, size_t& length)
+{
+	v8::String::Value text(value);
+	length = text.length();
+	if (length > capacity) {
+		return "value is too long for the field";
+	}
+	if (!Encode(codePage, *text, length, data)) {
+		return "character can't be represented in the code page";
+	}
+	return NULL;
+}
+
+} // namespace transcode
+
+} // namespace node_adabas
@@ -0,0 +1,73 @@
+#ifndef NODE_ADABAS_SRC_TRANSCODE_H
+#define NODE_ADABAS_SRC_TRANSCODE_H
+
+#include <node.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace node_adabas {
+
+/*
+ * Conversions of alphanumeric data between code pages of Adabas (Latin-1
+ * and EBCDIC) and JS strings.
+ */
+namespace transcode {
+
+/*
+ * Code pages (all EBCDIC code pages map to Latin-1 characters).
+ */
+enum CodePage {
+	LATIN1,
+	CP037,
+	CP500,
+	CP1047
+};
+
+/*
+ * Finds code page by name ('latin1', 'cp037', 'cp500', 'cp1047').
+ * Returns false if code page is unknown.
+ */
+bool FindCodePage(const char* name, CodePage& codePage);
+const char* CodePageName(CodePage codePage);
+
+/*
+ * Returns blank character of the code page.
+ */
+unsigned char Blank(CodePage codePage);
+
+/*
+ * Returns true if all bytes are ASCII characters.
+ */
+bool IsAscii(const unsigned char* data, size_t length);
+
+/*
+ * Decodes bytes of the code page into UTF-16 text of the same length.
+ */
+void Decode(CodePage codePage, const unsigned char* data, size_t length,
+	uint16_t* text);
+
+/*
+ * Encodes UTF-16 text into bytes of the code page. Returns false if some
+ * character can't be represented in the code page.
+ */
+bool Encode(CodePage codePage, const uint16_t* text, size_t length,
+	unsigned char* data);
+
+/*
+ * Creates JS string from bytes of the code page.
+ */
+v8::Local<v8::String> NewString(CodePage codePage,
+	const unsigned char* data, size_t length);
+
+/*
+ * Writes JS string into bytes of the code page, 'length' receives number
+ * of bytes written. Returns error message or NULL.
+ */
+const char* WriteString(CodePage codePage, v8::Handle<v8::Value> value,
+	unsigned char* data, size_t capacity, size_t& length);
+
+} // namespace transcode
+
+} // namespace node_adabas
+
+#endif // NODE_ADABAS_SRC_TRANSCODE_H
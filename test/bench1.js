@@ -0,0 +1,45 @@
+// Compares synchronous exec() (through the thread pool) with execSync()
+// (in the calling thread) on the L1 command loop.
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var numRequests = parseInt(process.argv[2], 10) || 10000;
+
+var db = new adabas.Adabas();
+
+var formatBuffer = new Buffer('AO,250,A.');
+var recordBuffer = new Buffer(250);
+var query = new adabas.Command()
+  .setCommandCode('L1')
+  .setDbId(88)
+  .setFileNo(12)
+  .setIsn(1)
+  .setFormatBufferLength(formatBuffer.length)
+  .setFormatBuffer(formatBuffer)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+
+function bench(name, exec) {
+  var start = process.hrtime();
+  for (var i = 0; i < numRequests; i++) {
+    exec(query);
+  }
+  var time = process.hrtime(start);
+  var ns = time[0] * 1e9 + time[1];
+  console.error('%s: %d requests, %d us/request, %d requests/s',
+    name, numRequests, (ns / numRequests / 1000).toFixed(2),
+    Math.round(numRequests * 1e9 / ns));
+}
+
+// Warm up both paths.
+db.exec(query);
+db.execSync(query);
+
+bench('exec', function(query) { return db.exec(query); });
+bench('execSync', function(query) { return db.execSync(query); });
+
+db.close();
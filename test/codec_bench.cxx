@@ -0,0 +1,137 @@
+/*
+ * Micro-benchmark of the decimal column kernels against the scalar
+ * decoding (per-digit loop with double arithmetic).
+ *
+ * g++ -O2 -I../src codec_bench.cxx ../src/codec.cxx
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include "codec.h"
+
+using namespace node_adabas;
+
+#define NUM_RECORDS 100000
+#define NUM_LOOPS 50
+#define RECORD_LENGTH 32
+#define PACKED_OFFSET 0
+#define PACKED_LENGTH 8
+#define UNPACKED_OFFSET 8
+#define UNPACKED_LENGTH 15
+
+static double
+Now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+ScalarPacked(const unsigned char* data, uint32_t length)
+{
+	double value = 0;
+	for (uint32_t i = 0; i < length - 1; i++) {
+		value = value * 100 + (data[i] >> 4) * 10 + (data[i] & 0x0F);
+	}
+	value = value * 10 + (data[length - 1] >> 4);
+	unsigned char sign = data[length - 1] & 0x0F;
+	return sign == 0x0B || sign == 0x0D ? -value : value;
+}
+
+static double
+ScalarUnpacked(const unsigned char* data, uint32_t length)
+{
+	double value = 0;
+	for (uint32_t i = 0; i < length; i++) {
+		value = value * 10 + (data[i] & 0x0F);
+	}
+	unsigned char sign = data[length - 1] & 0xF0;
+	return sign == 0x70 || sign == 0xD0 || sign == 0xB0 ? -value : value;
+}
+
+static void
+Report(const char* name, double scalarTime, double columnTime)
+{
+	double numValues = double(NUM_RECORDS) * NUM_LOOPS;
+	printf("%-9s scalar %6.2f ns/value, %s %6.2f ns/value, x%.2f\n",
+		name, scalarTime * 1e9 / numValues, codec::SimdLevel(),
+		columnTime * 1e9 / numValues, scalarTime / columnTime);
+}
+
+int
+main(void)
+{
+	std::vector<unsigned char> records(NUM_RECORDS * RECORD_LENGTH);
+	std::vector<double> expected(NUM_RECORDS);
+	srand(1);
+	for (size_t i = 0; i < NUM_RECORDS; i++) {
+		int64_t value = (int64_t(rand()) << 20 | rand()) % 100000000000000LL;
+		if (i % 3 == 0) {
+			value = -value;
+		}
+		expected[i] = double(value);
+		unsigned char* record = &records[i * RECORD_LENGTH];
+		codec::EncodePacked(value, record + PACKED_OFFSET, PACKED_LENGTH);
+		codec::EncodeUnpacked(value, record + UNPACKED_OFFSET,
+			UNPACKED_LENGTH);
+	}
+
+	std::vector<double> values(NUM_RECORDS);
+	volatile double sum = 0;
+
+	// Packed decimals.
+	double start = Now();
+	for (int loop = 0; loop < NUM_LOOPS; loop++) {
+		for (size_t i = 0; i < NUM_RECORDS; i++) {
+			values[i] = ScalarPacked(
+				&records[i * RECORD_LENGTH + PACKED_OFFSET], PACKED_LENGTH);
+		}
+		sum += values[loop];
+	}
+	double scalarTime = Now() - start;
+
+	start = Now();
+	for (int loop = 0; loop < NUM_LOOPS; loop++) {
+		codec::DecodePackedColumn(&records[PACKED_OFFSET], RECORD_LENGTH,
+			PACKED_LENGTH, NUM_RECORDS, &values[0]);
+		sum += values[loop];
+	}
+	double columnTime = Now() - start;
+	if (memcmp(&values[0], &expected[0], NUM_RECORDS * sizeof(double))) {
+		printf("packed decimals are decoded incorrectly\n");
+		return 1;
+	}
+	Report("packed", scalarTime, columnTime);
+
+	// Unpacked decimals.
+	start = Now();
+	for (int loop = 0; loop < NUM_LOOPS; loop++) {
+		for (size_t i = 0; i < NUM_RECORDS; i++) {
+			values[i] = ScalarUnpacked(
+				&records[i * RECORD_LENGTH + UNPACKED_OFFSET],
+				UNPACKED_LENGTH);
+		}
+		sum += values[loop];
+	}
+	scalarTime = Now() - start;
+
+	start = Now();
+	for (int loop = 0; loop < NUM_LOOPS; loop++) {
+		codec::DecodeUnpackedColumn(&records[UNPACKED_OFFSET],
+			RECORD_LENGTH, UNPACKED_LENGTH, NUM_RECORDS, &values[0]);
+		sum += values[loop];
+	}
+	columnTime = Now() - start;
+	if (memcmp(&values[0], &expected[0], NUM_RECORDS * sizeof(double))) {
+		printf("unpacked decimals are decoded incorrectly\n");
+		return 1;
+	}
+	Report("unpacked", scalarTime, columnTime);
+
+	return 0;
+}
@@ -0,0 +1,57 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas();
+
+var recordBuffer = new Buffer('UPD=12.');
+var query = new adabas.Command()
+  .setCommandCode('OP')
+  .setDbId(88)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+var rc = db.exec(query);
+assert(rc === adabas.ADA_SUCCESS);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var recordBuffer = new Buffer(250);
+query
+  .clear()
+  .setCommandCode('L2')
+  .setCommandId('EXPT')
+  .setDbId(88)
+  .setFileNo(12)
+  .setFormatBufferLength(formatBuffer.length)
+  .setFormatBuffer(formatBuffer)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+
+var stream = db.createReadStream(query, { chunkRecords: 16, prefetch: 2 });
+var numRecords = 0;
+
+stream.on('readable', function() {
+  var chunk;
+  while ((chunk = stream.read()) !== null) {
+    assert(chunk.records.length === chunk.isns.length * 250);
+    numRecords += chunk.isns.length;
+  }
+});
+
+stream.on('end', function() {
+  assert(stream.rc === adabas.ADA_SUCCESS);
+  assert(stream.numRecords === numRecords);
+  console.error('Readed records: %d', numRecords);
+
+  query
+    .clear()
+    .setCommandCode('CL')
+    .setDbId(88);
+  rc = db.exec(query);
+  assert(rc === adabas.ADA_SUCCESS);
+
+  db.close();
+});
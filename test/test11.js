@@ -0,0 +1,73 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas();
+
+var recordBuffer = new Buffer('UPD=12.');
+var query = new adabas.Command()
+  .setCommandCode('OP')
+  .setDbId(88)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+var rc = db.exec(query);
+assert(rc === adabas.ADA_SUCCESS);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var recordBuffer = new Buffer(250 * 64);
+var isnBuffer = new Buffer(4 + 16 * 64);
+query
+  .clear()
+  .setCommandCode('L2')
+  .setCommandId('EXPT')
+  .setDbId(88)
+  .setFileNo(12)
+  .setFormatBufferLength(formatBuffer.length)
+  .setFormatBuffer(formatBuffer)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer)
+  .setIsnBufferLength(isnBuffer.length)
+  .setIsnBuffer(isnBuffer)
+  .setMultiFetch(0, 50);
+
+var numCalls = 0;
+var numRecords = 0;
+while (db.exec(query) === adabas.ADA_SUCCESS &&
+  query.getReturnCode() === adabas.ADA_NORMAL)
+{
+  var records = query.getMultiFetch(recordBuffer);
+  assert(records.length > 0 && records.length <= 64);
+  assert(query.getIsnLowerLimit() >= 1 && query.getIsnLowerLimit() <= 64);
+  records.forEach(function(record) {
+    assert(record.slice.length === record.length);
+    assert(record.slice.parent === recordBuffer.parent);
+  });
+  numCalls++;
+  numRecords += records.length;
+}
+assert(query.getReturnCode() === adabas.ADA_EOF);
+
+console.error('Readed records: %d in %d calls', numRecords, numCalls);
+
+query
+  .clear()
+  .setCommandCode('CL')
+  .setDbId(88);
+rc = db.exec(query);
+assert(rc === adabas.ADA_SUCCESS);
+
+// Lengths in the control block longer than buffers are bounded.
+var shortIsnBuffer = new Buffer(4);
+shortIsnBuffer.writeUInt32LE(10, 0);
+var broken = new adabas.Command()
+  .setRecordBufferLength(1000)
+  .setRecordBuffer(new Buffer(10))
+  .setIsnBufferLength(4 + 16 * 10)
+  .setIsnBuffer(shortIsnBuffer);
+assert.throws(function() { broken.getMultiFetch(); }, /number of records/);
+
+db.close();
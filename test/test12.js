@@ -0,0 +1,82 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var format = 'AA,8,A,AB,2,P,AC,4,F,2X,AD,0,A.';
+var fb = adabas.compileFormat(format);
+assert(fb === adabas.compileFormat(format));
+assert(fb.toString() === format);
+assert(fb.getRecordLength() === 8 + 2 + 4 + 2 + 1);
+
+var record = new Buffer(8 + 2 + 4 + 2 + 4);
+record.write('SMITH   ', 0, 'ascii');
+record[8] = 0x12;
+record[9] = 0x3D;
+record.writeInt32LE(-5, 10);
+record.write('  ', 14, 'ascii');
+record[16] = 4;
+record.write('ABC', 17, 'ascii');
+
+var object = fb.decode(record);
+assert.deepEqual(object, { AA: 'SMITH', AB: -123, AC: -5, AD: 'ABC' });
+
+assert.throws(function() { fb.decode(record.slice(0, 10)); });
+assert.throws(function() { adabas.compileFormat('AA,8.'); });
+
+var command = new adabas.Command();
+var target = new Buffer(64);
+var length = fb.encode({ AA: 'JONES', AB: 42, AC: 7, AD: 'XY' }, target,
+  command);
+assert(length === 8 + 2 + 4 + 2 + 3);
+assert(command.getRecordBufferLength() === length);
+assert.deepEqual(fb.decode(target),
+  { AA: 'JONES', AB: 42, AC: 7, AD: 'XY' });
+
+assert.throws(function() { fb.encode({ AA: 'TOO LONG NAME' }, target); });
+assert.throws(function() { fb.encode({ AB: 1000 }, target); });
+assert.throws(function() { fb.encode({ AC: NaN }, target); });
+assert.throws(function() { fb.encode({ AC: Infinity }, target); });
+assert.throws(function() { fb.encode({ AC: 2147483648 }, target); });
+assert.throws(function() { adabas.compileFormat('AA,8,A,0X.'); });
+
+var fixed = adabas.compileFormat('AA,1,F,AB,8,F.');
+var fixedRecord = new Buffer(9);
+fixed.encode({ AA: -128, AB: -9007199254740991 }, fixedRecord);
+assert.deepEqual(fixed.decode(fixedRecord),
+  { AA: -128, AB: -9007199254740991 });
+assert.throws(function() { fixed.encode({ AA: 128 }, fixedRecord); });
+assert.throws(function() { fixed.encode({ AB: 1e19 }, fixedRecord); });
+
+// Decimals, which are not exact in double, are returned as strings.
+var big = adabas.compileFormat('AA,10,P,AB,12,U.');
+var bigRecord = new Buffer(22);
+big.encode({ AA: '-1234567890123456789', AB: 42 }, bigRecord);
+assert.deepEqual(big.decode(bigRecord),
+  { AA: '-1234567890123456789', AB: 42 });
+
+// Batch of records, decimals are decoded by column kernels.
+var batch = adabas.compileFormat('AA,4,A,AB,5,P,AC,8,U.');
+var batchBuffer = new Buffer(17 * 100);
+for (var i = 0; i < 100; i++) {
+  batch.encode({ AA: 'R' + i, AB: -i * 1000, AC: i }, batchBuffer.slice(i * 17));
+}
+var records = batch.decodeMany(batchBuffer, 100);
+assert(records.length === 100);
+for (var i = 0; i < 100; i++) {
+  assert.deepEqual(records[i], { AA: 'R' + i, AB: -i * 1000, AC: i });
+}
+
+// 16-digit unpacked decimals may exceed 2^53, so decodeMany() decodes
+// them like decode() (exact value or string of digits).
+var wide = adabas.compileFormat('AA,16,U.');
+var wideBuffer = new Buffer(16 * 2);
+wide.encode({ AA: '9007199254740993' }, wideBuffer);
+wide.encode({ AA: 12345 }, wideBuffer.slice(16));
+var wideRecords = wide.decodeMany(wideBuffer, 2);
+assert.deepEqual(wideRecords[0], { AA: '9007199254740993' });
+assert.deepEqual(wideRecords[0], wide.decode(wideBuffer));
+assert.deepEqual(wideRecords[1], { AA: 12345 });
@@ -0,0 +1,36 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+// Latin-1 characters are decoded as characters, not as UTF-8 bytes.
+var fb = adabas.compileFormat('AA,6,A,AB,0,A.');
+var record = new Buffer(6 + 4);
+fb.encode({ AA: 'Müller', AB: 'Åse' }, record);
+assert(record[1] === 0xFC);
+assert(record[6] === 4);
+assert.deepEqual(fb.decode(record), { AA: 'Müller', AB: 'Åse' });
+
+// Characters outside of the code page are rejected instead of truncated.
+assert.throws(function() { fb.encode({ AA: '€' }, record); });
+
+// EBCDIC record, trailing EBCDIC blanks are removed.
+var ebcdic = adabas.compileFormat('AA,8,A,AB,2,P.', 'cp037');
+assert(ebcdic !== adabas.compileFormat('AA,8,A,AB,2,P.'));
+assert(ebcdic === adabas.compileFormat('AA,8,A,AB,2,P.', 'cp037'));
+record = new Buffer(10);
+ebcdic.encode({ AA: 'Smith', AB: 12 }, record);
+assert.deepEqual(Array.prototype.slice.call(record, 0, 8),
+  [0xE2, 0x94, 0x89, 0xA3, 0x88, 0x40, 0x40, 0x40]);
+assert.deepEqual(ebcdic.decode(record), { AA: 'Smith', AB: 12 });
+
+assert.throws(function() { adabas.compileFormat('AA,8,A.', 'cp999'); });
+
+// Control block strings.
+var command = new adabas.Command();
+assert.throws(function() { command.setCommandId('€ABC'); });
+command.setCommandId('ÅBCD');
+assert(command.getCommandId() === 'ÅBCD');
@@ -0,0 +1,34 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+function find(name, from, to) {
+  return adabas.where('AW,6,A').eq(name).and('AB,4,U').between(from, to);
+}
+
+var search = find('READER', 100, 200);
+assert(search.toString() === 'AW,6,A,D,AB,4,U,S,AB,4,U.');
+assert(search.plan() === find('WRITER', 1, 2).plan());
+
+var command = new adabas.Command();
+search.apply(command);
+assert(command.getSearchBufferLength() === 25);
+assert(command.getValueBufferLength() === 6 + 4 + 4);
+var valueBuffer = command._searchValueBuffer;
+assert(valueBuffer.toString('ascii', 0, 14) === 'READER01000200');
+
+// Repeated search rewrites the value buffer of the command in place.
+find('WRITER', 1, 2).apply(command);
+assert(command._searchValueBuffer === valueBuffer);
+assert(valueBuffer.toString('ascii', 0, 14) === 'WRITER00010002');
+
+// Length and format are taken from the value.
+search = adabas.where('AA').eq('SMITH').or('AC').gt(5);
+assert(search.toString() === 'AA,5,A,O,AC,4,F,GT.');
+
+assert.throws(function() { adabas.where('AA').and('AB'); });
+assert.throws(function() { adabas.where('AA').plan(); });
@@ -0,0 +1,61 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas();
+var query = new adabas.Command()
+  .setCommandCode('OP')
+  .setDbId(88);
+var rc = db.exec(query);
+assert(rc === adabas.ADA_SUCCESS);
+
+// ISN buffer is a view of the buffer, not a copy.
+var isnBuffer = new Buffer(64 * 4);
+query
+  .clear()
+  .setCommandCode('S1')
+  .setCommandId('ISNL')
+  .setDbId(88)
+  .setFileNo(12)
+  .setIsnBufferLength(isnBuffer.length)
+  .setIsnBuffer(isnBuffer);
+adabas.where('AW,6,A').eq('READER').apply(query);
+
+var view = query.getIsnBuffer();
+assert(view.length === 64);
+assert(view.buffer === isnBuffer);
+isnBuffer.writeUInt32LE(12345, 4);
+assert(view[1] === 12345);
+
+var numPageIsns = 0;
+var lastIsn = 0;
+db.readIsns(query, { maxIsns: 1000 },
+  function(isns) {
+    assert(isns.length > 0 && isns.length <= 64);
+    for (var i = 0; i < isns.length; i++) {
+      assert(isns[i] > lastIsn);
+      lastIsn = isns[i];
+    }
+    numPageIsns += isns.length;
+  },
+  function(err, rc, numIsns) {
+    assert(!err);
+    assert(rc === adabas.ADA_SUCCESS);
+    assert(numIsns === numPageIsns);
+    assert(numIsns <= 1000);
+
+    console.error('Found ISNs: %d of %d', numIsns, query.getIsnQuantity());
+
+    query
+      .clear()
+      .setCommandCode('CL')
+      .setDbId(88);
+    rc = db.exec(query);
+    assert(rc === adabas.ADA_SUCCESS);
+
+    db.close();
+  });
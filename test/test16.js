@@ -0,0 +1,41 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas();
+var command = new adabas.Command();
+
+// Buffer is taken from the pool and owned by the command.
+var recordBuffer = db.reserve(command, 'record', 1000);
+assert(recordBuffer.length === 1000);
+assert(command.getRecordBuffer() === recordBuffer);
+assert(command.getRecordBufferLength() === 1000);
+assert(db.stats().bufferPool.misses === 1);
+
+// Long enough buffer of the command is reused.
+assert(db.reserve(command, 'record', 500) === recordBuffer);
+assert(command.getRecordBufferLength() === 500);
+
+var formatBuffer = new Buffer('AA,8,A.');
+command.setFormatBuffer(formatBuffer);
+assert(command.getFormatBuffer() === formatBuffer);
+assert(db.reserve(command, 'format', 7) === formatBuffer);
+
+assert.throws(function() { db.reserve(command, 'other', 10); });
+assert.throws(function() { db.reserve(command, 'isn', 0); });
+
+// Block of the collected buffer returns to the pool (node --expose-gc).
+if (typeof gc === 'function') {
+  command.clear();
+  recordBuffer = null;
+  gc();
+  assert(db.stats().bufferPool.freeBytes > 0);
+  db.reserve(command, 'record', 800);
+  assert(db.stats().bufferPool.hits === 1);
+}
+
+db.close();
@@ -0,0 +1,57 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var template = adabas.Command.prepare({
+  commandCode: 'L1',
+  dbId: 88,
+  fileNo: 12,
+  formatBuffer: 'AA,8,A.',
+  recordBuffer: 8
+});
+assert(template.getCommandCode() === 'L1');
+assert(template.getFormatBufferLength() === 7);
+assert(template.getRecordBufferLength() === 8);
+assert.throws(function() { adabas.Command.prepare({ unknown: 1 }); });
+
+// Format buffer is shared, record buffer is private.
+var command = template.clone();
+assert(command.getDbId() === 88);
+assert(command.getFileNo() === 12);
+assert(command.getFormatBuffer() === template.getFormatBuffer());
+assert(command.getRecordBuffer() !== template.getRecordBuffer());
+assert(command.getRecordBuffer().length === 8);
+
+var pool = new adabas.CommandPool(template);
+var first = pool.acquire();
+first.setIsn(10).setFileNo(13);
+var recordBuffer = first.getRecordBuffer();
+pool.release(first);
+
+// Recycled command is reset to the template, buffers are kept.
+var second = pool.acquire();
+assert(second === first);
+assert(second.getIsn() === 0);
+assert(second.getFileNo() === 12);
+assert(second.getRecordBuffer() === recordBuffer);
+assert.deepEqual(pool.stats(), { created: 1, reused: 1, free: 0 });
+
+// Template buffer is default contents, up to the length in the control
+// block; pool of the owning instance provides new buffers.
+var db = new adabas.Adabas();
+var valueTemplate = adabas.Command.prepare({
+  commandCode: 'S1',
+  valueBuffer: 'ABCDEFGH',
+  valueBufferLength: 4
+});
+var misses = db.stats().bufferPool.misses;
+var valuePool = new adabas.CommandPool(valueTemplate, { db: db });
+var clone = valuePool.acquire();
+assert(db.stats().bufferPool.misses === misses + 1);
+assert(clone.getValueBuffer().length === 8);
+assert(clone.getValueBuffer().toString('binary', 0, 4) === 'ABCD');
+db.close();
@@ -0,0 +1,49 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var command = new adabas.Command();
+var cb = command.cb;
+assert(command.cb === cb);
+assert(cb.buffer.length === adabas.controlBlockLayout.size);
+
+// Fields written through the buffer are seen by native getters.
+cb.commandCode = 'L1';
+cb.commandId = 'CID1';
+cb.dbId = 88;
+cb.fileNo = 12;
+cb.isn = 1234;
+cb.recordBufferLength = 250;
+cb.addition1 = [65, 66, 67, 68, 69, 70, 71, 72];
+assert(command.getCommandCode() === 'L1');
+assert(command.getCommandId() === 'CID1');
+assert(command.getDbId() === 88);
+assert(command.getFileNo() === 12);
+assert(command.getIsn() === 1234);
+assert(command.getRecordBufferLength() === 250);
+assert.deepEqual(command.getAddition1(), [65, 66, 67, 68, 69, 70, 71, 72]);
+
+// Fields written by native setters are seen through the buffer.
+command.setIsnQuantity(99).setFileNo(1000);
+assert(cb.isnQuantity === 99);
+assert(cb.fileNo === 1000);
+assert(cb.dbId === 88);
+assert.throws(function() { return cb.returnCode; });
+assert.throws(function() { cb.returnCode = 5; });
+assert(cb.fileNo === 1000);
+
+// Alphanumeric fields are validated also in fast mode.
+assert.throws(function() { cb.commandCode = 'L'; });
+assert.throws(function() { cb.commandId = 'CI\u20ac1'; });
+assert(command.getCommandCode() === 'L1');
+assert(command.getCommandId() === 'CID1');
+
+// Debug mode validates values by native setters.
+adabas.ControlBlock.debug = true;
+assert.throws(function() { cb.commandCode = 'TOOLONG'; });
+assert.throws(function() { cb.returnCode = -1; });
+adabas.ControlBlock.debug = false;
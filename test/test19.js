@@ -0,0 +1,63 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var recordBuffer = new Buffer(100);
+var command = new adabas.Command().set({
+  commandCode: 'L3',
+  commandId: 'CID1',
+  dbId: 88,
+  fileNo: 12,
+  isn: 0,
+  recordBufferLength: recordBuffer.length,
+  recordBuffer: recordBuffer,
+  addition1: [65, 65, 32, 32, 32, 32, 32, 32]
+});
+assert(command.getCommandCode() === 'L3');
+assert(command.getDbId() === 88);
+assert(command.getFileNo() === 12);
+assert(command.getRecordBuffer() === recordBuffer);
+
+var fields = command.get(adabas.FIELD_COMMAND_CODE | adabas.FIELD_FILE_NO |
+  adabas.FIELD_RECORD_BUFFER_LENGTH);
+assert.deepEqual(Object.keys(fields),
+  ['commandCode', 'fileNo', 'recordBufferLength']);
+assert(fields.commandCode === 'L3');
+assert(fields.fileNo === 12);
+assert(fields.recordBufferLength === 100);
+
+// File number is set together with database ID.
+command.set({ fileNo: 1000 });
+assert(command.get().fileNo === 1000);
+assert(command.get().dbId === 88);
+
+assert.throws(function() { command.set({ isn: -1 }); }, /isn/);
+assert.throws(function() { command.set({ commandCode: 'L' }); });
+
+// Command isn't changed if any field is invalid.
+assert.throws(function() {
+  command.set({ dbId: 99, fileNo: 13, isn: 5, recordBuffer: 'x' });
+}, /recordBuffer/);
+assert(command.getDbId() === 88);
+assert(command.getFileNo() === 1000);
+assert(command.getIsn() === 0);
+assert(command.getRecordBuffer() === recordBuffer);
+
+// Return code holds database ID and file number of physical file numbers.
+var physical = new adabas.Command().set({ dbId: 300, fileNo: 1000 });
+assert.throws(function() { physical.set({ returnCode: 5 }); },
+  /return code used as database ID/);
+assert.throws(function() {
+  command.set({ dbId: 300, fileNo: 12, returnCode: 5 });
+}, /returnCode/);
+assert(physical.getDbId() === 300);
+assert(physical.getFileNo() === 1000);
+assert(!('returnCode' in physical.get()));
+assert(command.getDbId() === 88);
+physical.set({ dbId: 88, fileNo: 12, returnCode: 3 });
+assert(physical.getReturnCode() === 3);
+assert(physical.get().returnCode === 3);
@@ -0,0 +1,56 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas({ timing: true });
+
+var phases = ['wakeup', 'queue', 'dispatch', 'call', 'completion', 'total',
+  'commandTime'];
+assert.deepEqual(Object.keys(db.timing()), phases);
+assert(db.timing().total.count === 0);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var recordBuffer = new Buffer(250);
+var query = new adabas.Command()
+  .setCommandCode('L1')
+  .setDbId(88)
+  .setFileNo(12)
+  .setIsn(1)
+  .setFormatBufferLength(formatBuffer.length)
+  .setFormatBuffer(formatBuffer)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+
+var numRequests = 10;
+var numFinished = 0;
+
+for (var i = 0; i < numRequests; i++) {
+  db.exec(query.clone(), function(rc, timing) {
+    assert(rc === adabas.ADA_SUCCESS);
+
+    // Breakdown of the request in microseconds.
+    assert.deepEqual(Object.keys(timing), phases);
+    assert(timing.total >= timing.call);
+
+    if (++numFinished === numRequests) {
+      var total = db.timing(true).total;
+      assert(total.count === numRequests);
+      assert(total.min <= total.p50 && total.p50 <= total.p99);
+      assert(total.p99 <= total.max);
+      assert(db.timing().total.count === 0);
+
+      // Requests aren't timed without option 'timing'.
+      var untimed = new adabas.Adabas();
+      untimed.exec(query, function(rc, timing) {
+        assert(arguments.length === 1);
+        assert(untimed.timing().total.count === 0);
+        untimed.close();
+        db.close();
+      });
+    }
+  });
+}
@@ -0,0 +1,53 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas();
+assert.deepEqual(db.stats().commands, []);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var recordBuffer = new Buffer(250);
+var query = new adabas.Command()
+  .setCommandCode('L1')
+  .setDbId(88)
+  .setFileNo(12)
+  .setIsn(1)
+  .setFormatBufferLength(formatBuffer.length)
+  .setFormatBuffer(formatBuffer)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+
+// Calls of main thread and pool threads are counted together.
+assert(db.execSync(query) === adabas.ADA_SUCCESS);
+
+db.exec(query, function(rc) {
+  assert(rc === adabas.ADA_SUCCESS);
+
+  var commands = db.stats().commands;
+  assert(commands.length === 1);
+  assert(commands[0].commandCode === 'L1');
+  assert(commands[0].dbId === 88);
+  assert(commands[0].fileNo === 12);
+  assert(commands[0].responseCode === query.getReturnCode());
+  assert(commands[0].count === 2);
+  assert(commands[0].totalTime > 0);
+
+  var labels = 'command="L1",dbid="88",file="12",response="' +
+    query.getReturnCode() + '"';
+  var text = db.prometheus();
+  assert(text.indexOf('# TYPE adabas_commands_total counter\n') >= 0);
+  assert(text.indexOf('adabas_commands_total{' + labels + '} 2\n') >= 0);
+  assert(text.indexOf('adabas_command_duration_seconds_bucket{' + labels +
+    ',le="+Inf"} 2\n') >= 0);
+  assert(text.indexOf('adabas_command_duration_seconds_count{' + labels +
+    '} 2\n') >= 0);
+
+  assert(db.prometheus('db1').indexOf('db1_commands_total{') >= 0);
+  assert.throws(function() { db.prometheus(1); });
+
+  db.close();
+});
@@ -0,0 +1,72 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+assert.throws(function() { new adabas.Adabas({ sampleWindow: 0 }); });
+
+var db = new adabas.Adabas({
+  maxThreads: 2,
+  queueDepth: 4,
+  sampleIntervalMs: 50,
+  sampleWindow: 3
+});
+
+var gauges = db.gauges();
+assert(gauges.queuedRequests === 0);
+assert(gauges.inFlight === 0);
+assert(gauges.perThread.length === 2);
+assert(gauges.perThread[0].state === 'stopped');
+assert.deepEqual(gauges.samples, []);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var recordBuffer = new Buffer(250);
+var query = new adabas.Command()
+  .setCommandCode('L1')
+  .setDbId(88)
+  .setFileNo(12)
+  .setIsn(1)
+  .setFormatBufferLength(formatBuffer.length)
+  .setFormatBuffer(formatBuffer)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+
+// Requests above the queue depth are rejected with EBUSY.
+var numFinished = 0;
+var numRejected = 0;
+for (var i = 0; i < 6; i++) {
+  db.exec(query.clone(), function(err) {
+    if (err instanceof Error) {
+      assert(err.code === 'EBUSY');
+      numRejected++;
+      return;
+    }
+    numFinished++;
+  });
+}
+assert(numRejected === 2);
+assert(db.gauges().inFlight === 4);
+assert(db.gauges().busyRejections === 2);
+
+setTimeout(function() {
+  assert(numFinished === 4);
+
+  gauges = db.gauges();
+  assert(gauges.inFlight === 0);
+  assert(gauges.wakeUps >= 1);
+  assert(gauges.perThread[0].state !== 'stopped');
+
+  // Window keeps the last samples, oldest first.
+  var samples = gauges.samples;
+  assert(samples.length === 3);
+  assert(samples[0].time <= samples[1].time);
+  assert(samples[1].time <= samples[2].time);
+  samples.forEach(function(sample) {
+    assert(sample.busyPercent >= 0 && sample.busyPercent <= 100);
+  });
+
+  db.close();
+}, 500);
@@ -0,0 +1,74 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+assert.throws(function() { new adabas.Adabas({ slowCommandBytes: 5000 }); });
+
+var db = new adabas.Adabas({
+  flightRecorder: 4,
+  dumpOnSignal: true
+});
+assert.deepEqual(db.flightRecorder(), []);
+assert.deepEqual(db.slowLog(), []);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var recordBuffer = new Buffer(250);
+var query = new adabas.Command()
+  .setCommandCode('L1')
+  .setDbId(88)
+  .setFileNo(12)
+  .setFormatBufferLength(formatBuffer.length)
+  .setFormatBuffer(formatBuffer)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+
+// Flight recorder keeps the last calls of the thread.
+for (var isn = 1; isn <= 6; isn++) {
+  assert(db.execSync(query.setIsn(isn)) === adabas.ADA_SUCCESS);
+}
+var calls = db.flightRecorder();
+assert(calls.length === 4);
+assert.deepEqual(calls.map(function(call) { return call.isn; }),
+  [3, 4, 5, 6]);
+assert(calls[0].thread === -1);
+assert(calls[0].commandCode === 'L1');
+assert(calls[0].dbId === 88);
+assert(calls[0].fileNo === 12);
+assert(calls[0].formatBufferLength === formatBuffer.length);
+assert(calls[0].recordBufferLength === recordBuffer.length);
+assert(calls[0].rc === adabas.ADA_SUCCESS);
+assert(calls[0].time <= calls[3].time);
+assert(calls[0].duration >= 0);
+
+var text = db.dumpFlightRecorder();
+assert(/^Flight recorder:\n/.test(text));
+assert(/\[main\] -[\d.]+ms L1 .*db=88 file=12 .*isn=6 /.test(text));
+assert(text.indexOf('Slow log:\n') > 0);
+
+// Fractional threshold makes every call slow.
+assert.throws(function() { new adabas.Adabas({ slowCommandMs: -1 }); });
+var slowDb = new adabas.Adabas({
+  slowCommandMs: 0.000001,
+  slowCommandBytes: 4
+});
+slowDb.exec(query.setIsn(1), function(rc) {
+  assert(rc === adabas.ADA_SUCCESS);
+
+  var slowCalls = slowDb.slowLog();
+  assert(slowCalls.length > 0);
+  slowCalls.forEach(function(slowCall) {
+    assert(slowCall.duration >= 0.001);
+    assert(slowCall.thread === 0);
+    assert(slowCall.formatBuffer.toString() === 'AO,2');
+    assert(slowCall.recordBuffer.length === 4);
+    assert(slowCall.searchBuffer.length === 0);
+  });
+  assert.deepEqual(slowDb.flightRecorder(), []);
+
+  slowDb.close();
+  db.close();
+});
@@ -0,0 +1,44 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas({
+  maxThreads: 1,
+  queueDepth: 4,
+  waitQueue: 4
+});
+
+var command = new adabas.Command()
+  .setCommandCode('L1')
+  .setDbId(88)
+  .setFileNo(12)
+  .setIsn(1);
+
+// Requests outstanding on close() get results or error ECANCELED.
+var numCalled = 0;
+function onResult(err) {
+  if (err instanceof Error) {
+    assert(err.code === 'ECANCELED');
+  }
+  numCalled++;
+}
+
+db.execMany([command.clone(), command.clone()], onResult);
+db.execChain([command.clone(), command.clone()], onResult);
+for (var i = 0; i < 4; i++) {
+  db.exec(command.clone(), onResult);
+}
+assert(db.stats().pendingCallbacks === 6);
+
+// Callbacks are called on the next turn of the loop, not by close().
+db.close();
+assert(numCalled === 0);
+
+process.on('exit', function() {
+  assert(numCalled === 6);
+  assert(db.stats().pendingCallbacks === 0);
+});
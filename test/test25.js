@@ -0,0 +1,42 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas({ maxThreads: 2, queueDepth: 16 });
+
+var command = new adabas.Command()
+  .setCommandCode('L1')
+  .setDbId(88)
+  .setFileNo(12)
+  .setIsn(1);
+
+// The first callback closes the object, while other requests are still
+// finished or queued; each callback is called once.
+var numCalled = 0;
+var closed = false;
+function onResult(err) {
+  if (err instanceof Error) {
+    assert(err.code === 'ECANCELED');
+  }
+  numCalled++;
+  if (!closed) {
+    closed = true;
+    db.close();
+  }
+}
+
+db.execMany([command.clone(), command.clone()], onResult);
+db.execChain([command.clone(), command.clone()], onResult);
+for (var i = 0; i < 8; i++) {
+  db.exec(command.clone(), onResult);
+}
+
+process.on('exit', function() {
+  assert(closed);
+  assert(numCalled === 10);
+  assert(db.stats().pendingCallbacks === 0);
+});
@@ -0,0 +1,46 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas({ minThreads: 1, maxThreads: 4, idleTimeoutMs: 100 });
+
+var stats = db.stats();
+assert(stats.threads === 0);
+assert(stats.minThreads === 1);
+assert(stats.maxThreads === 4);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var numRequests = 8;
+var numFinished = 0;
+
+for (var isn = 1; isn <= numRequests; isn++) {
+  var recordBuffer = new Buffer(250);
+  var query = new adabas.Command()
+    .setCommandCode('L1')
+    .setDbId(88)
+    .setFileNo(12)
+    .setIsn(isn)
+    .setFormatBufferLength(formatBuffer.length)
+    .setFormatBuffer(formatBuffer)
+    .setRecordBufferLength(recordBuffer.length)
+    .setRecordBuffer(recordBuffer);
+
+  db.exec(query, function(rc) {
+    assert(rc === adabas.ADA_SUCCESS);
+    if (++numFinished === numRequests) {
+      stats = db.stats();
+      console.error('Threads in pool: %d', stats.threads);
+      assert(stats.threads >= 1 && stats.threads <= 4);
+
+      // Threads above minimum leave the pool after idle timeout.
+      setTimeout(function() {
+        assert(db.stats().threads === 1);
+        db.close();
+      }, 500);
+    }
+  });
+}
@@ -0,0 +1,46 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas({ maxThreads: 4 });
+
+var formatBuffer = new Buffer('AO,250,A.');
+var commands = [];
+for (var isn = 1; isn <= 10; isn++) {
+  var recordBuffer = new Buffer(250);
+  commands.push(new adabas.Command()
+    .setCommandCode('L1')
+    .setDbId(88)
+    .setFileNo(12)
+    .setIsn(isn)
+    .setFormatBufferLength(formatBuffer.length)
+    .setFormatBuffer(formatBuffer)
+    .setRecordBufferLength(recordBuffer.length)
+    .setRecordBuffer(recordBuffer));
+}
+
+// Batch must fit into the queue.
+var smallDb = new adabas.Adabas({ queueDepth: 4 });
+assert.throws(function() {
+  smallDb.execMany(commands, function() { assert(false); });
+}, /queue depth/);
+smallDb.close();
+
+db.execMany(commands, function(err, results) {
+  assert(!err);
+  assert(results.length === commands.length);
+
+  var seen = {};
+  results.forEach(function(result) {
+    assert(result.rc === adabas.ADA_SUCCESS);
+    seen[result.index] = true;
+  });
+  assert(Object.keys(seen).length === commands.length);
+
+  console.error('Executed commands: %d', results.length);
+  db.close();
+});
@@ -0,0 +1,46 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas({
+  maxThreads: 2,
+  sessionsPerThread: 4,
+  sessionDbId: 88,
+  sessionRecordBuffer: 'UPD=12.'
+});
+
+var sessions = db.sessions();
+assert(sessions.length === 8);
+
+var searchBuffer = new Buffer('AW,6,A.');
+var valueBuffer = new Buffer('READER');
+var numFinished = 0;
+
+sessions.forEach(function(session) {
+  var query = new adabas.Command()
+    .setSession(session.session)
+    .setCommandCode('S1')
+    .setDbId(88)
+    .setFileNo(12)
+    .setSearchBufferLength(searchBuffer.length)
+    .setSearchBuffer(searchBuffer)
+    .setValueBufferLength(valueBuffer.length)
+    .setValueBuffer(valueBuffer);
+
+  db.exec(query, function(rc) {
+    assert(rc === adabas.ADA_SUCCESS);
+    console.error('Session %d found records: %d',
+      query.getSession(), query.getIsnQuantity());
+
+    if (++numFinished === sessions.length) {
+      db.sessions().forEach(function(session) {
+        assert(session.rc === adabas.ADA_NORMAL);
+      });
+      db.close();
+    }
+  });
+});
@@ -0,0 +1,57 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas({
+  maxThreads: 2,
+  queueDepth: 8,
+  highWaterMark: 6,
+  lowWaterMark: 2,
+  waitQueue: 4
+});
+
+var stats = db.stats();
+assert(stats.queueDepth === 8);
+assert(stats.highWaterMark === 6);
+assert(stats.lowWaterMark === 2);
+
+var command = new adabas.Command()
+  .setCommandCode('L1')
+  .setDbId(88)
+  .setFileNo(12)
+  .setIsn(1);
+
+var accepted = 0;
+var rejected = 0;
+var completed = 0;
+var drained = false;
+
+db.on('drain', function() {
+  drained = true;
+});
+
+function onExec(err, rc) {
+  if (err) {
+    assert(err.code === 'EBUSY');
+    rejected++;
+  } else {
+    completed++;
+  }
+  if (completed + rejected === 16) {
+    // 8 slots + 4 waiting requests are accepted, the rest is rejected.
+    assert(completed === accepted);
+    assert(completed === 12);
+    assert(drained);
+    db.close();
+  }
+}
+
+for (var i = 0; i < 16; i++) {
+  if (db.exec(command, onExec) || db.stats().pendingCallbacks > accepted) {
+    accepted++;
+  }
+}
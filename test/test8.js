@@ -0,0 +1,48 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas();
+
+var recordBuffer = new Buffer('UPD=12.');
+var open = new adabas.Command()
+  .setCommandCode('OP')
+  .setDbId(88)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var reads = [];
+for (var isn = 1; isn <= 5; isn++) {
+  var readBuffer = new Buffer(250);
+  reads.push(new adabas.Command()
+    .setCommandCode('L1')
+    .setDbId(88)
+    .setFileNo(12)
+    .setIsn(isn)
+    .setFormatBufferLength(formatBuffer.length)
+    .setFormatBuffer(formatBuffer)
+    .setRecordBufferLength(readBuffer.length)
+    .setRecordBuffer(readBuffer));
+}
+
+var close = new adabas.Command()
+  .setCommandCode('CL')
+  .setDbId(88);
+
+var chain = [open].concat(reads, [close]);
+db.execChain(chain, { stopOnRc: true }, function(err, rcs) {
+  assert(!err);
+  assert(rcs.length <= chain.length);
+  for (var i = 0; i < rcs.length; i++) {
+    assert(rcs[i] === adabas.ADA_SUCCESS);
+  }
+  if (rcs.length === chain.length) {
+    assert(close.getReturnCode() === adabas.ADA_NORMAL);
+  }
+  db.close();
+});
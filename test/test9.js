@@ -0,0 +1,59 @@
+var assert = require('assert');
+
+try {
+  var adabas = require('adabas');
+} catch (err) {
+  var adabas = require('..');
+}
+
+var db = new adabas.Adabas();
+
+var recordBuffer = new Buffer('UPD=12.');
+var query = new adabas.Command()
+  .setCommandCode('OP')
+  .setDbId(88)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+var rc = db.exec(query);
+assert(rc === adabas.ADA_SUCCESS);
+
+var formatBuffer = new Buffer('AO,250,A.');
+var recordBuffer = new Buffer(250);
+query
+  .clear()
+  .setCommandCode('L2')
+  .setCommandId('EXPT')
+  .setDbId(88)
+  .setFileNo(12)
+  .setFormatBufferLength(formatBuffer.length)
+  .setFormatBuffer(formatBuffer)
+  .setRecordBufferLength(recordBuffer.length)
+  .setRecordBuffer(recordBuffer);
+
+var numChunkRecords = 0;
+db.readAll(query, { maxRecords: 1000, chunkRecords: 64 },
+  function(chunk, isns) {
+    assert(isns.length > 0 && isns.length <= 64);
+    assert(chunk.length === isns.length * recordBuffer.length);
+    numChunkRecords += isns.length;
+  },
+  function(err, rc, numRecords) {
+    assert(!err);
+    assert(rc === adabas.ADA_SUCCESS);
+    assert(numRecords === numChunkRecords);
+    assert(numRecords <= 1000);
+    if (numRecords < 1000) {
+      assert(query.getReturnCode() === adabas.ADA_EOF);
+    }
+
+    console.error('Readed records: %d', numRecords);
+
+    query
+      .clear()
+      .setCommandCode('CL')
+      .setDbId(88);
+    rc = db.exec(query);
+    assert(rc === adabas.ADA_SUCCESS);
+
+    db.close();
+  });